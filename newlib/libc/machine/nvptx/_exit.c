@@ -23,9 +23,18 @@
    error, not a link error.  */
 int *__attribute((weak)) __exitval_ptr;
 
+/* Partial lines still held by putchar; see linebuf.c.  */
+extern void __nvptx_line_flush_all (void);
+
+/* Heap counts and leaks; see heapprof.c.  */
+extern void __nvptx_heap_report (void);
+
 void __attribute__((noreturn))
 _exit (int status)
 {
+  __nvptx_line_flush_all ();
+  __nvptx_heap_report ();
+
   if (__exitval_ptr)
     {
       *__exitval_ptr = status;
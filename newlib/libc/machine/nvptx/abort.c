@@ -15,9 +15,14 @@
 
 #include <stdlib.h>
 
+/* Partial lines still held by putchar; see linebuf.c.  */
+extern void __nvptx_line_flush_all (void);
+
 void __attribute__((noreturn))
 abort (void)
 {
+  __nvptx_line_flush_all ();
+
   for (;;)
     __builtin_trap ();
 }
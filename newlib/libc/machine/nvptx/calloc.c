@@ -13,14 +13,39 @@
  * they apply.
  */
 
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
+#include "machine/heapprof.h"
+#include "heap.h"
 
 void *
-calloc (size_t size, size_t len)
+__nvptx_calloc_at (size_t size, size_t len, const char *file, int line)
 {
-  void *p = malloc (size * len);
+  size_t total;
+  if (__builtin_mul_overflow (size, len, &total))
+    {
+      errno = ENOMEM;
+      return NULL;
+    }
+
+  /* A pooled block is zeroed already, or zeroed here only as far as
+     needed.  */
+  void *p = __nvptx_heap_pool_take (total, 1);
+  if (p)
+    {
+      __nvptx_heap_note_alloc (p, file, line);
+      return p;
+    }
+
+  p = __nvptx_malloc_at (total, file, line);
   if (!p)
     return p;
-  return memset (p, 0, size * len);
+  return memset (p, 0, total);
+}
+
+void *
+calloc (size_t size, size_t len)
+{
+  return __nvptx_calloc_at (size, len, NULL, 0);
 }
@@ -1,18 +1,151 @@
 /* clock.c
  * Support file for nvptx in newlib.
  */
+
+/* Time keeping for clock, clock_gettime and gettimeofday.
+
+   Time is counted by %globaltimer, a nanosecond timer shared by the whole
+   device.  Builds for targets below sm_31 count %clock64 cycles instead,
+   at the rate in __nvptx_clock.clock64_hz: the host may store the SM clock
+   rate there before launch, or the program may measure it with
+   __nvptx_clock_calibrate.  Until then, 1250 MHz is assumed.
+
+   CLOCK_MONOTONIC starts wherever the counter does.  CLOCK_REALTIME adds
+   __nvptx_clock.realtime_offset, which the host may set to the Unix time
+   in nanoseconds at which the counter read zero; otherwise it is the same
+   as CLOCK_MONOTONIC.
+
+   The conversions are in clockmath.h, which the host tests check.  */
+
+#include <errno.h>
 #include <time.h>
+#include <sys/time.h>
+#include "machine/clock.h"
+#include "clockmath.h"
+
+/* How long __nvptx_clock_calibrate measures.  */
+#define CLOCK_CALIBRATION_NS 1000000ull
+
+struct __nvptx_clock __nvptx_clock;
+
+#ifdef __nvptx__
+static unsigned long long
+read_globaltimer (void)
+{
+  unsigned long long now;
+  asm volatile ("mov.u64 %0, %%globaltimer;" : "=r" (now));
+  return now;
+}
+
+static unsigned long long
+read_clock64 (void)
+{
+  unsigned long long now;
+  asm volatile ("mov.u64 %0, %%clock64;" : "=r" (now));
+  return now;
+}
+
+/* Nanoseconds on the device's monotonic clock.  */
+
+static unsigned long long
+monotonic_ns (void)
+{
+#if __PTX_SM__ >= 310
+  return read_globaltimer ();
+#else
+  return clock64_to_ns (read_clock64 (), __nvptx_clock.clock64_hz);
+#endif
+}
+
+/* Measure the %clock64 rate against %globaltimer, which every target can
+   read even where it isn't used for time keeping, by spinning for
+   CLOCK_CALIBRATION_NS.  Returns the rate, which is also stored for the
+   %clock64 fallback.  Each SM has its own %clock64, and the measurement
+   assumes the calling thread stays on one SM, which it does.  */
+
+unsigned long long
+__nvptx_clock_calibrate (void)
+{
+  unsigned long long ns0 = read_globaltimer ();
+  unsigned long long cycles0 = read_clock64 ();
+  unsigned long long ns, cycles;
+
+  do
+    {
+      ns = read_globaltimer ();
+      cycles = read_clock64 ();
+    }
+  while (ns - ns0 < CLOCK_CALIBRATION_NS);
+
+  unsigned long long hz = clock_rate (cycles - cycles0, ns - ns0);
+  if (hz)
+    __nvptx_clock.clock64_hz = hz;
+  return hz;
+}
 
 clock_t
 clock ()
 {
-  unsigned long long now;
+  return monotonic_ns () / (NSEC_PER_SEC / CLOCKS_PER_SEC);
+}
+
+int
+clock_gettime (clockid_t clock_id, struct timespec *tp)
+{
+  unsigned long long ns;
+
+  switch (clock_id)
+    {
+    case CLOCK_MONOTONIC:
+      ns = monotonic_ns ();
+      break;
+
+    case CLOCK_REALTIME:
+      ns = monotonic_ns () + __nvptx_clock.realtime_offset;
+      break;
+
+    default:
+      errno = EINVAL;
+      return -1;
+    }
+
+  tp->tv_sec = ns / NSEC_PER_SEC;
+  tp->tv_nsec = ns % NSEC_PER_SEC;
+  return 0;
+}
+
+int
+clock_getres (clockid_t clock_id, struct timespec *res)
+{
+  if (clock_id != CLOCK_MONOTONIC && clock_id != CLOCK_REALTIME)
+    {
+      errno = EINVAL;
+      return -1;
+    }
+
+  if (res)
+    {
+      res->tv_sec = 0;
 #if __PTX_SM__ >= 310
-  asm volatile("mov.u64 %0, %%globaltimer;" : "=r"(now));
-  return now/((1000000000ull)/CLOCKS_PER_SEC);
+      res->tv_nsec = 1;
 #else
-  asm volatile("mov.u64 %0, %%clock64;" : "=r"(now));
-  // Assume a GPU base clock frequency of 1250MHz.
-  return now/((1250000000ull)/CLOCKS_PER_SEC);
+      res->tv_nsec = clock64_to_ns (1, __nvptx_clock.clock64_hz) ?: 1;
 #endif
+    }
+  return 0;
 }
+
+int
+gettimeofday (struct timeval *tv, void *tz)
+{
+  /* The time zone is obsolete and not filled in.  */
+  unsigned long long ns = monotonic_ns () + __nvptx_clock.realtime_offset;
+
+  if (tv)
+    {
+      tv->tv_sec = ns / NSEC_PER_SEC;
+      tv->tv_usec = ns % NSEC_PER_SEC / 1000;
+    }
+  return 0;
+}
+#endif
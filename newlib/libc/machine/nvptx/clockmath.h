@@ -0,0 +1,58 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Internal counter arithmetic of clock.c.  It doesn't depend on the GPU,
+   so tests/clock-test.c checks it on the host.  */
+
+#ifndef _NVPTX_CLOCKMATH_H_
+#define _NVPTX_CLOCKMATH_H_
+
+#define NSEC_PER_SEC 1000000000ull
+
+/* Default %clock64 rate, until the host or __nvptx_clock_calibrate sets
+   the actual one.  */
+#define CLOCK64_DEFAULT_HZ 1250000000ull
+
+/* Return the rate of a counter that advanced CYCLES in NS nanoseconds, in
+   cycles per second, or 0 if NS is 0.  The product CYCLES * NSEC_PER_SEC
+   is formed in two parts, which doesn't overflow for NS below 18 s.  */
+
+static inline unsigned long long
+clock_rate (unsigned long long cycles, unsigned long long ns)
+{
+  if (!ns)
+    return 0;
+  return cycles / ns * NSEC_PER_SEC + cycles % ns * NSEC_PER_SEC / ns;
+}
+
+/* Convert CYCLES of a counter running at HZ to nanoseconds, again in two
+   parts, which doesn't overflow for HZ below 18 GHz.  */
+
+static inline unsigned long long
+cycles_to_ns (unsigned long long cycles, unsigned long long hz)
+{
+  return cycles / hz * NSEC_PER_SEC + cycles % hz * NSEC_PER_SEC / hz;
+}
+
+/* Convert %clock64 CYCLES to nanoseconds at HZ, the stored rate, or at
+   CLOCK64_DEFAULT_HZ if HZ is 0.  */
+
+static inline unsigned long long
+clock64_to_ns (unsigned long long cycles, unsigned long long hz)
+{
+  return cycles_to_ns (cycles, hz ? hz : CLOCK64_DEFAULT_HZ);
+}
+
+#endif /* _NVPTX_CLOCKMATH_H_ */
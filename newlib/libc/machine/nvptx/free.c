@@ -14,6 +14,7 @@
  */
 
 #include <stdlib.h>
+#include "heap.h"
 
 /* The CUDA-provided free.  */
 void sys_free (void *) __asm__ ("free");
@@ -22,5 +23,9 @@ void sys_free (void *) __asm__ ("free");
 void free (void *ptr)
 {
   if (ptr)
-    sys_free ((long long *)ptr - 1);
+    {
+      __nvptx_heap_note_free (ptr);
+      if (!__nvptx_heap_pool_put (ptr))
+	sys_free ((char *)ptr - heap_header (ptr)->offset);
+    }
 }
@@ -0,0 +1,115 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Layout of the blocks handed out by malloc and friends.
+
+   The CUDA heap returns blocks aligned to HEAP_ALIGN bytes.  Every user
+   pointer is preceded by a struct heap_header of the same size, so that
+   plain allocations keep the heap's alignment.  An aligned allocation
+   gets a heap block with enough slack to move the user pointer up to the
+   requested alignment; the header then sits right in front of the moved
+   pointer and records how far it moved, so that free and realloc find
+   the heap block again.
+
+   Plain blocks of up to HEAP_POOL_MAX bytes come in HEAP_POOL_CLASSES
+   size classes, doubling from HEAP_ALIGN bytes, and are kept in pools
+   when they're freed; see heappool.c.
+
+   Libraries built with NVPTX_HEAP_PROFILE double the header to also
+   record where the block was allocated, and report every allocation,
+   free and realloc copy to heapprof.c.  */
+
+#ifndef _NVPTX_HEAP_H_
+#define _NVPTX_HEAP_H_
+
+#include <stddef.h>
+
+/* Alignment of the blocks of the CUDA heap, and of malloc's results.  */
+#define HEAP_ALIGN 16
+
+struct heap_site;
+
+struct heap_header
+{
+#ifdef NVPTX_HEAP_PROFILE
+  struct heap_site *site;	/* Call site, for the leak report.  */
+  size_t reserved;		/* Keeps the header a multiple of HEAP_ALIGN.  */
+#endif
+  size_t offset;	/* Bytes from the heap block to the user pointer.  */
+  size_t size;		/* Size the user asked for.  */
+};
+
+static inline struct heap_header *
+heap_header (void *ptr)
+{
+  return (struct heap_header *) ptr - 1;
+}
+
+/* Return the user pointer at OFFSET into the heap block BLOCK, recording
+   SIZE in its header.  */
+
+static inline void *
+heap_user_ptr (void *block, size_t offset, size_t size)
+{
+  void *ptr = (char *) block + offset;
+  heap_header (ptr)->offset = offset;
+  heap_header (ptr)->size = size;
+  return ptr;
+}
+
+#define HEAP_POOL_CLASSES 9
+#define HEAP_POOL_MAX ((size_t) HEAP_ALIGN << (HEAP_POOL_CLASSES - 1))
+
+/* Return the size class of a block of SIZE bytes, or -1 if it's too
+   large to be pooled.  */
+
+static inline int
+heap_pool_class (size_t size)
+{
+  if (size > HEAP_POOL_MAX)
+    return -1;
+
+  int cls = 0;
+  while ((size_t) HEAP_ALIGN << cls < size)
+    cls++;
+  return cls;
+}
+
+/* Return how many bytes to allocate for a block of SIZE bytes, so that
+   it can go into the pool of its size class later.  */
+
+static inline size_t
+heap_block_size (size_t size)
+{
+  int cls = heap_pool_class (size);
+  return cls < 0 ? size : (size_t) HEAP_ALIGN << cls;
+}
+
+extern void *__nvptx_heap_pool_take (size_t, int);
+extern int __nvptx_heap_pool_put (void *);
+
+#ifdef NVPTX_HEAP_PROFILE
+extern void __nvptx_heap_note_alloc (void *, const char *, int);
+extern void __nvptx_heap_note_free (void *);
+extern void __nvptx_heap_note_failure (void);
+extern void __nvptx_heap_note_copy (size_t);
+#else
+#define __nvptx_heap_note_alloc(ptr, file, line) ((void) 0)
+#define __nvptx_heap_note_free(ptr) ((void) 0)
+#define __nvptx_heap_note_failure() ((void) 0)
+#define __nvptx_heap_note_copy(size) ((void) 0)
+#endif
+
+#endif /* _NVPTX_HEAP_H_ */
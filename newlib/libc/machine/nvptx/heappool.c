@@ -0,0 +1,195 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Pools of freed heap blocks; see machine/heappool.h.
+
+   Every size class has two pools of HEAP_POOL_SLOTS blocks each: dirty
+   blocks, as free left them, and clean ones, which are zero all the way
+   through.  A slot holds the user pointer of a block, or NULL.  Blocks go
+   in by compare-and-swap into an empty slot and come out by exchanging
+   NULL into a full one, so no locks are needed.  Each pool also counts
+   its blocks, so that finding it empty or full takes a single load; the
+   count is updated after the slot, so it may be off by a little for a
+   moment, which only costs a wasted look.
+
+   Only plain blocks are pooled, those whose user pointer sits right after
+   the header: they are allocated with the full size of their class (see
+   heap_block_size), so any request of that class fits them.  Zeroing
+   uses 16-byte stores, since blocks and class sizes are multiples of
+   HEAP_ALIGN.  */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "machine/heappool.h"
+#include "heap.h"
+
+#ifndef HEAP_POOL_SLOTS
+#define HEAP_POOL_SLOTS 64
+#endif
+
+/* The CUDA-provided free.  */
+void sys_free (void *) __asm__ ("free");
+
+typedef unsigned long long heap_vec __attribute__ ((vector_size (16)));
+
+struct heap_pool
+{
+  int count;			/* Blocks in the slots.  */
+  unsigned int hint;		/* The slot filled last.  */
+  void *slots[HEAP_POOL_SLOTS];
+};
+
+static struct heap_pool dirty_pools[HEAP_POOL_CLASSES];
+static struct heap_pool clean_pools[HEAP_POOL_CLASSES];
+
+static void *
+pool_take (struct heap_pool *pool)
+{
+  if (__atomic_load_n (&pool->count, __ATOMIC_RELAXED) <= 0)
+    return NULL;
+
+  /* The block freed last is the most likely to still be in the cache.  */
+  unsigned int start = __atomic_load_n (&pool->hint, __ATOMIC_RELAXED);
+  for (unsigned int i = 0; i < HEAP_POOL_SLOTS; i++)
+    {
+      void **slot = &pool->slots[(start + i) % HEAP_POOL_SLOTS];
+      if (!__atomic_load_n (slot, __ATOMIC_RELAXED))
+	continue;
+
+      void *ptr = __atomic_exchange_n (slot, NULL, __ATOMIC_ACQUIRE);
+      if (ptr)
+	{
+	  __atomic_fetch_sub (&pool->count, 1, __ATOMIC_RELAXED);
+	  return ptr;
+	}
+    }
+  return NULL;
+}
+
+static int
+pool_put (struct heap_pool *pool, void *ptr)
+{
+  if (__atomic_load_n (&pool->count, __ATOMIC_RELAXED) >= HEAP_POOL_SLOTS)
+    return 0;
+
+  unsigned int start = (uintptr_t) ptr / HEAP_ALIGN;
+  for (unsigned int i = 0; i < HEAP_POOL_SLOTS; i++)
+    {
+      unsigned int index = (start + i) % HEAP_POOL_SLOTS;
+      void **slot = &pool->slots[index];
+      void *expected = NULL;
+      if (!__atomic_load_n (slot, __ATOMIC_RELAXED)
+	  && __atomic_compare_exchange_n (slot, &expected, ptr, 0,
+					  __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+	{
+	  __atomic_fetch_add (&pool->count, 1, __ATOMIC_RELAXED);
+	  __atomic_store_n (&pool->hint, index, __ATOMIC_RELAXED);
+	  return 1;
+	}
+    }
+  return 0;
+}
+
+/* Zero the first SIZE bytes of the block at PTR, rounded up to whole
+   16-byte words.  */
+
+static void
+zero_block (void *ptr, size_t size)
+{
+  heap_vec *words = (heap_vec *) ptr;
+  size_t nwords = (size + sizeof (heap_vec) - 1) / sizeof (heap_vec);
+
+  for (size_t i = 0; i < nwords; i++)
+    words[i] = (heap_vec) { 0, 0 };
+}
+
+/* Return a pooled block for SIZE bytes, with its header filled in, or
+   NULL if there is none.  If ZERO is non-zero, the block is zeroed, which
+   costs nothing if a clean one is found.  Otherwise, dirty blocks are
+   used first, to leave the clean ones to calloc.  */
+
+void *
+__nvptx_heap_pool_take (size_t size, int zero)
+{
+  int cls = heap_pool_class (size);
+  if (cls < 0)
+    return NULL;
+
+  void *ptr = zero ? pool_take (&clean_pools[cls]) : NULL;
+  if (!ptr)
+    {
+      ptr = pool_take (&dirty_pools[cls]);
+      if (ptr && zero)
+	zero_block (ptr, size);
+    }
+  if (!ptr && !zero)
+    ptr = pool_take (&clean_pools[cls]);
+  if (!ptr)
+    return NULL;
+
+  heap_header (ptr)->size = size;
+  return ptr;
+}
+
+/* Keep the freed block PTR for reuse.  Returns 0 if it can't be pooled,
+   and has to go back to the heap.  */
+
+int
+__nvptx_heap_pool_put (void *ptr)
+{
+  struct heap_header *header = heap_header (ptr);
+  int cls = heap_pool_class (header->size);
+
+  if (header->offset != sizeof (struct heap_header) || cls < 0)
+    return 0;
+  return pool_put (&dirty_pools[cls], ptr);
+}
+
+size_t
+__nvptx_heap_scrub (size_t max_bytes)
+{
+  size_t zeroed = 0;
+
+  for (int cls = 0; cls < HEAP_POOL_CLASSES; cls++)
+    {
+      size_t bytes = (size_t) HEAP_ALIGN << cls;
+      void *ptr;
+
+      while ((!max_bytes || zeroed < max_bytes)
+	     && __atomic_load_n (&clean_pools[cls].count, __ATOMIC_RELAXED)
+		< HEAP_POOL_SLOTS
+	     && (ptr = pool_take (&dirty_pools[cls])))
+	{
+	  zero_block (ptr, bytes);
+	  zeroed += bytes;
+	  if (!pool_put (&clean_pools[cls], ptr))
+	    sys_free ((char *) ptr - sizeof (struct heap_header));
+	}
+    }
+  return zeroed;
+}
+
+void
+__nvptx_heap_drain (void)
+{
+  for (int cls = 0; cls < HEAP_POOL_CLASSES; cls++)
+    {
+      void *ptr;
+      while ((ptr = pool_take (&dirty_pools[cls])))
+	sys_free ((char *) ptr - sizeof (struct heap_header));
+      while ((ptr = pool_take (&clean_pools[cls])))
+	sys_free ((char *) ptr - sizeof (struct heap_header));
+    }
+}
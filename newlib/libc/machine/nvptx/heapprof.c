@@ -0,0 +1,324 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Heap profiling for malloc and friends.
+
+   A library built with NVPTX_HEAP_PROFILE counts allocations, frees,
+   failed allocations, realloc copies and the live and peak bytes, and
+   keeps a histogram of allocation sizes.  So that the threads of a warp
+   don't contend with the whole device for every count, the counters live
+   in a table of NVPTX_HEAP_PROF_SLOTS slots indexed by SM and warp, and
+   are only added up when they're read.
+
+   The peak needs a device-wide count of live bytes, though.  Each slot
+   keeps the change in live bytes since it last updated that count, and
+   only updates it, and the peak, once the change reaches HEAP_PROF_BATCH
+   bytes.  The peak may therefore miss up to that many bytes per slot;
+   allocations of HEAP_PROF_BATCH bytes or more always show up in it.
+
+   The heap header of every block points at the block's call site in a
+   table of NVPTX_HEAP_PROF_SITES sites, which counts the blocks from each
+   site that are not yet freed; see machine/heapprof.h for how call sites
+   are recorded.  __nvptx_heap_report, which _exit calls, lists every site
+   that still has blocks.  */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "machine/heapprof.h"
+#include "heap.h"
+
+#ifdef NVPTX_HEAP_PROFILE
+
+#ifndef NVPTX_HEAP_PROF_SLOTS
+#define NVPTX_HEAP_PROF_SLOTS 256
+#endif
+
+#ifndef NVPTX_HEAP_PROF_SITES
+#define NVPTX_HEAP_PROF_SITES 256
+#endif
+
+#define HEAP_PROF_BATCH 4096
+
+struct heap_prof_slot
+{
+  unsigned long long allocs;
+  unsigned long long frees;
+  unsigned long long failures;
+  unsigned long long realloc_copied;
+  long long live_pending;	/* Not yet added to heap_live.  */
+  unsigned long long classes[NVPTX_HEAP_PROF_CLASSES];
+};
+
+/* States of a call site's entry.  */
+enum
+{
+  SITE_FREE,
+  SITE_CLAIMED,			/* Being filled in.  */
+  SITE_READY
+};
+
+struct heap_site
+{
+  const char *file;
+  int line;
+  int state;
+  unsigned long long blocks;	/* Blocks from here not yet freed.  */
+  unsigned long long bytes;	/* Their size.  */
+};
+
+static struct heap_prof_slot heap_prof_slots[NVPTX_HEAP_PROF_SLOTS];
+static long long heap_live, heap_peak;
+
+static struct heap_site heap_sites[NVPTX_HEAP_PROF_SITES];
+
+/* Blocks allocated without a call site, and those from sites that didn't
+   fit into heap_sites.  */
+static struct heap_site site_unknown = { NULL, 0, SITE_READY };
+static struct heap_site site_other = { NULL, 0, SITE_READY };
+
+static struct heap_prof_slot *
+heap_prof_slot (void)
+{
+  unsigned int smid, nwarpid, warpid;
+  asm ("mov.u32 %0, %%smid;" : "=r" (smid));
+  asm ("mov.u32 %0, %%nwarpid;" : "=r" (nwarpid));
+  asm volatile ("mov.u32 %0, %%warpid;" : "=r" (warpid));
+  return &heap_prof_slots[(smid * nwarpid + warpid) % NVPTX_HEAP_PROF_SLOTS];
+}
+
+static unsigned int
+heap_prof_class (size_t size)
+{
+  if (size <= 16)
+    return 0;
+
+  /* Bits needed for SIZE - 1, less the 4 bits that class 0 covers.  */
+  unsigned int class = 64 - __builtin_clzll (size - 1) - 4;
+  return class < NVPTX_HEAP_PROF_CLASSES ? class : NVPTX_HEAP_PROF_CLASSES - 1;
+}
+
+static void
+heap_prof_live (struct heap_prof_slot *slot, long long delta)
+{
+  long long pending = __atomic_add_fetch (&slot->live_pending, delta,
+					  __ATOMIC_RELAXED);
+  if (pending > -HEAP_PROF_BATCH && pending < HEAP_PROF_BATCH)
+    return;
+
+  pending = __atomic_exchange_n (&slot->live_pending, 0, __ATOMIC_RELAXED);
+  long long live = __atomic_add_fetch (&heap_live, pending, __ATOMIC_RELAXED);
+  long long peak = __atomic_load_n (&heap_peak, __ATOMIC_RELAXED);
+  while (live > peak
+	 && !__atomic_compare_exchange_n (&heap_peak, &peak, live, 1,
+					  __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    ;
+}
+
+/* Return the entry of the call site FILE:LINE, adding it if it's new.
+   Two threads adding the same site at once may both get an entry; the
+   report adds such duplicates up.  */
+
+static struct heap_site *
+heap_site (const char *file, int line)
+{
+  if (!file)
+    return &site_unknown;
+
+  unsigned int hash = (unsigned int) ((uintptr_t) file >> 3) * 31 + line;
+  for (int i = 0; i < NVPTX_HEAP_PROF_SITES; i++)
+    {
+      struct heap_site *site = &heap_sites[(hash + i) % NVPTX_HEAP_PROF_SITES];
+      int state = __atomic_load_n (&site->state, __ATOMIC_ACQUIRE);
+
+      if (state == SITE_READY && site->file == file && site->line == line)
+	return site;
+      if (state == SITE_FREE
+	  && __atomic_compare_exchange_n (&site->state, &state, SITE_CLAIMED,
+					  0, __ATOMIC_ACQUIRE,
+					  __ATOMIC_RELAXED))
+	{
+	  site->file = file;
+	  site->line = line;
+	  __atomic_store_n (&site->state, SITE_READY, __ATOMIC_RELEASE);
+	  return site;
+	}
+    }
+
+  return &site_other;
+}
+
+void
+__nvptx_heap_note_alloc (void *ptr, const char *file, int line)
+{
+  struct heap_prof_slot *slot = heap_prof_slot ();
+  size_t size = heap_header (ptr)->size;
+  struct heap_site *site = heap_site (file, line);
+
+  heap_header (ptr)->site = site;
+  __atomic_add_fetch (&site->blocks, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch (&site->bytes, size, __ATOMIC_RELAXED);
+
+  __atomic_add_fetch (&slot->allocs, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch (&slot->classes[heap_prof_class (size)], 1,
+		      __ATOMIC_RELAXED);
+  heap_prof_live (slot, size);
+}
+
+void
+__nvptx_heap_note_free (void *ptr)
+{
+  struct heap_prof_slot *slot = heap_prof_slot ();
+  size_t size = heap_header (ptr)->size;
+  struct heap_site *site = heap_header (ptr)->site;
+
+  __atomic_sub_fetch (&site->blocks, 1, __ATOMIC_RELAXED);
+  __atomic_sub_fetch (&site->bytes, size, __ATOMIC_RELAXED);
+
+  __atomic_add_fetch (&slot->frees, 1, __ATOMIC_RELAXED);
+  heap_prof_live (slot, -(long long) size);
+}
+
+void
+__nvptx_heap_note_failure (void)
+{
+  __atomic_add_fetch (&heap_prof_slot ()->failures, 1, __ATOMIC_RELAXED);
+}
+
+void
+__nvptx_heap_note_copy (size_t size)
+{
+  __atomic_add_fetch (&heap_prof_slot ()->realloc_copied, size,
+		      __ATOMIC_RELAXED);
+}
+
+int
+__nvptx_heap_stats (struct __nvptx_heap_stats *stats)
+{
+  long long live = __atomic_load_n (&heap_live, __ATOMIC_RELAXED);
+
+  memset (stats, 0, sizeof *stats);
+  for (int i = 0; i < NVPTX_HEAP_PROF_SLOTS; i++)
+    {
+      struct heap_prof_slot *slot = &heap_prof_slots[i];
+
+      stats->allocs += __atomic_load_n (&slot->allocs, __ATOMIC_RELAXED);
+      stats->frees += __atomic_load_n (&slot->frees, __ATOMIC_RELAXED);
+      stats->failures += __atomic_load_n (&slot->failures, __ATOMIC_RELAXED);
+      stats->realloc_copied += __atomic_load_n (&slot->realloc_copied,
+						__ATOMIC_RELAXED);
+      live += __atomic_load_n (&slot->live_pending, __ATOMIC_RELAXED);
+      for (int c = 0; c < NVPTX_HEAP_PROF_CLASSES; c++)
+	stats->classes[c] += __atomic_load_n (&slot->classes[c],
+					      __ATOMIC_RELAXED);
+    }
+
+  long long peak = __atomic_load_n (&heap_peak, __ATOMIC_RELAXED);
+  stats->live_bytes = live > 0 ? live : 0;
+  stats->peak_bytes = peak > live ? peak : stats->live_bytes;
+  return 0;
+}
+
+static int
+same_site (const struct heap_site *a, const struct heap_site *b)
+{
+  return a->line == b->line
+	 && (a->file == b->file || !strcmp (a->file, b->file));
+}
+
+/* Print BLOCKS and BYTES, the blocks of SITE not yet freed, if there are
+   any.  */
+
+static void
+report_site (const struct heap_site *site, unsigned long long blocks,
+	     unsigned long long bytes)
+{
+  if (!blocks)
+    return;
+  if (site == &site_unknown)
+    printf ("heap: %llu bytes in %llu blocks not freed, allocated without "
+	    "a call site\n", bytes, blocks);
+  else if (site == &site_other)
+    printf ("heap: %llu bytes in %llu blocks not freed, allocated at "
+	    "other call sites\n", bytes, blocks);
+  else
+    printf ("heap: %llu bytes in %llu blocks not freed, allocated at %s:%d\n",
+	    bytes, blocks, site->file, site->line);
+}
+
+void
+__nvptx_heap_report (void)
+{
+  struct __nvptx_heap_stats stats;
+
+  __nvptx_heap_stats (&stats);
+  printf ("heap: %llu allocations, %llu frees, %llu failures, "
+	  "%llu bytes live, %llu bytes peak, %llu bytes copied by realloc\n",
+	  stats.allocs, stats.frees, stats.failures, stats.live_bytes,
+	  stats.peak_bytes, stats.realloc_copied);
+  for (int c = 0; c < NVPTX_HEAP_PROF_CLASSES; c++)
+    if (stats.classes[c])
+      {
+	if (c < NVPTX_HEAP_PROF_CLASSES - 1)
+	  printf ("heap: %llu allocations of up to %llu bytes\n",
+		  stats.classes[c], 16ull << c);
+	else
+	  printf ("heap: %llu allocations of more than %llu bytes\n",
+		  stats.classes[c], 16ull << (c - 1));
+      }
+
+  for (int i = 0; i < NVPTX_HEAP_PROF_SITES; i++)
+    {
+      struct heap_site *site = &heap_sites[i];
+      unsigned long long blocks, bytes;
+      int first = 1;
+
+      if (__atomic_load_n (&site->state, __ATOMIC_ACQUIRE) != SITE_READY)
+	continue;
+      for (int j = 0; j < i && first; j++)
+	first = !(__atomic_load_n (&heap_sites[j].state, __ATOMIC_ACQUIRE)
+		  == SITE_READY && same_site (&heap_sites[j], site));
+      if (!first)
+	continue;
+
+      blocks = __atomic_load_n (&site->blocks, __ATOMIC_RELAXED);
+      bytes = __atomic_load_n (&site->bytes, __ATOMIC_RELAXED);
+      for (int j = i + 1; j < NVPTX_HEAP_PROF_SITES; j++)
+	if (__atomic_load_n (&heap_sites[j].state, __ATOMIC_ACQUIRE)
+	    == SITE_READY && same_site (&heap_sites[j], site))
+	  {
+	    blocks += __atomic_load_n (&heap_sites[j].blocks, __ATOMIC_RELAXED);
+	    bytes += __atomic_load_n (&heap_sites[j].bytes, __ATOMIC_RELAXED);
+	  }
+      report_site (site, blocks, bytes);
+    }
+  report_site (&site_other, site_other.blocks, site_other.bytes);
+  report_site (&site_unknown, site_unknown.blocks, site_unknown.bytes);
+}
+
+#else
+
+int
+__nvptx_heap_stats (struct __nvptx_heap_stats *stats)
+{
+  return -1;
+}
+
+void
+__nvptx_heap_report (void)
+{
+}
+
+#endif
@@ -0,0 +1,261 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Per-thread line assembly for putchar and puts.
+
+   Emitting every character as its own printf record is slow and lets the
+   output of many threads interleave character by character.  Instead,
+   characters are collected in a line buffer and a complete line goes out
+   as a single record, either at the newline or when the buffer fills up.
+
+   There is no thread-local storage on nvptx, so the buffers live in a
+   fixed table of NVPTX_LINE_SLOTS slots, indexed by the thread's id, which
+   unlike the SM and warp it runs on never changes.  A thread owns a slot
+   from its first buffered character up to the end of the line.  A thread
+   that finds its slot owned by another flushes the other's partial line
+   and takes the slot over; that is how the slots of threads that exit in
+   the middle of a line are reclaimed, and it only splits lines when more
+   threads than slots write at once.  While a thread appends to or emits
+   from a slot, the slot is marked busy and others wait.  Partial lines of
+   threads that never finish them are flushed by _exit and abort.
+
+   Except for the thread id, none of this depends on the GPU, so this file
+   also builds for the host, where it can be driven from threads.  */
+
+#include <stdarg.h>
+#include <stddef.h>
+#ifndef __nvptx__
+#include <sched.h>
+#endif
+
+#ifndef NVPTX_LINE_SLOTS
+#define NVPTX_LINE_SLOTS 2048
+#endif
+
+#ifndef NVPTX_LINE_MAX
+#define NVPTX_LINE_MAX 128
+#endif
+
+/* Set in the owner while the owner appends to or emits from the slot.  */
+#define LINE_BUSY (1ull << 63)
+
+/* Owner value used while _exit or abort flush a slot.  */
+#define LINE_FLUSHING (~0ull)
+
+extern int __nvptx_vprintf (const char *, va_list);
+
+struct line
+{
+  unsigned long long owner;	/* Thread id + 1 of the owner, or 0.  */
+  unsigned int len;
+  char buf[NVPTX_LINE_MAX + 1];	/* Room for the terminating nul.  */
+};
+
+static struct line lines[NVPTX_LINE_SLOTS];
+
+static unsigned long long
+line_thread_id (void)
+{
+#ifdef __nvptx__
+  unsigned int tid_x, tid_y, tid_z, ntid_x, ntid_y, ntid_z;
+  unsigned int ctaid_x, ctaid_y, ctaid_z, nctaid_x, nctaid_y;
+  asm ("mov.u32 %0, %%tid.x;" : "=r" (tid_x));
+  asm ("mov.u32 %0, %%tid.y;" : "=r" (tid_y));
+  asm ("mov.u32 %0, %%tid.z;" : "=r" (tid_z));
+  asm ("mov.u32 %0, %%ntid.x;" : "=r" (ntid_x));
+  asm ("mov.u32 %0, %%ntid.y;" : "=r" (ntid_y));
+  asm ("mov.u32 %0, %%ntid.z;" : "=r" (ntid_z));
+  asm ("mov.u32 %0, %%ctaid.x;" : "=r" (ctaid_x));
+  asm ("mov.u32 %0, %%ctaid.y;" : "=r" (ctaid_y));
+  asm ("mov.u32 %0, %%ctaid.z;" : "=r" (ctaid_z));
+  asm ("mov.u32 %0, %%nctaid.x;" : "=r" (nctaid_x));
+  asm ("mov.u32 %0, %%nctaid.y;" : "=r" (nctaid_y));
+
+  unsigned long long block = ((unsigned long long) ctaid_z * nctaid_y
+			      + ctaid_y) * nctaid_x + ctaid_x;
+  unsigned long long thread = ((unsigned long long) tid_z * ntid_y
+			       + tid_y) * ntid_x + tid_x;
+  return block * ((unsigned long long) ntid_x * ntid_y * ntid_z) + thread + 1;
+#else
+  static unsigned long long nthreads;
+  static __thread unsigned long long id;
+  if (!id)
+    id = __atomic_add_fetch (&nthreads, 1, __ATOMIC_RELAXED);
+  return id;
+#endif
+}
+
+static struct line *
+line_slot (unsigned long long self)
+{
+  return &lines[(self - 1) % NVPTX_LINE_SLOTS];
+}
+
+static int
+line_emit (const char *fmt, ...)
+{
+  va_list args;
+  int res;
+
+  va_start (args, fmt);
+  res = __nvptx_vprintf (fmt, args);
+  va_end (args);
+  return res;
+}
+
+/* Take the calling thread's slot and mark it busy, waiting while another
+   thread works on it.  A partial line of another owner is emitted first,
+   so the slot comes back holding the caller's partial line or none.  */
+
+static struct line *
+line_acquire (unsigned long long self)
+{
+  struct line *line = line_slot (self);
+  unsigned long long owner = __atomic_load_n (&line->owner, __ATOMIC_RELAXED);
+
+  for (;;)
+    {
+      if (owner & LINE_BUSY)
+	{
+#ifndef __nvptx__
+	  sched_yield ();
+#endif
+	  owner = __atomic_load_n (&line->owner, __ATOMIC_RELAXED);
+	}
+      else if (__atomic_compare_exchange_n (&line->owner, &owner,
+					    self | LINE_BUSY, 1,
+					    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+	break;
+    }
+
+  if (owner != self)
+    {
+      if (owner && line->len)
+	{
+	  line->buf[line->len] = '\0';
+	  line_emit ("%s", line->buf);
+	}
+      line->len = 0;
+    }
+  return line;
+}
+
+/* Done with LINE: it stays the caller's while it holds a partial line.  */
+
+static void
+line_unlock (struct line *line, unsigned long long self)
+{
+  __atomic_store_n (&line->owner, line->len ? self : 0, __ATOMIC_RELEASE);
+}
+
+/* Whether the calling thread may have a partial line.  Only the thread
+   itself makes itself the owner, so if it doesn't see itself there, it
+   has none.  */
+
+static int
+line_pending (unsigned long long self)
+{
+  unsigned long long owner = __atomic_load_n (&line_slot (self)->owner,
+					      __ATOMIC_RELAXED);
+  return (owner & ~LINE_BUSY) == self;
+}
+
+int
+__nvptx_line_putc (int c)
+{
+  unsigned long long self = line_thread_id ();
+  struct line *line = line_acquire (self);
+  int res = c;
+
+  line->buf[line->len++] = c;
+  if (c == '\n' || line->len == NVPTX_LINE_MAX)
+    {
+      line->buf[line->len] = '\0';
+      if (line_emit ("%s", line->buf) < 0)
+	res = -1;
+      line->len = 0;
+    }
+  line_unlock (line, self);
+  return res;
+}
+
+int
+__nvptx_line_puts (const char *str)
+{
+  unsigned long long self = line_thread_id ();
+
+  /* Only take the detour through the line buffer if there's a partial line
+     to complete, otherwise it's a single record anyway.  */
+  if (line_pending (self))
+    {
+      struct line *line = line_acquire (self);
+      line->buf[line->len] = '\0';
+      int res = line_emit ("%s%s\n", line->buf, str);
+      line->len = 0;
+      line_unlock (line, self);
+      return res;
+    }
+
+  return line_emit ("%s\n", str);
+}
+
+/* Emit the calling thread's partial line, if any, so that output that
+   doesn't go through the line buffers stays in order.  */
+
+void
+__nvptx_line_flush (void)
+{
+  unsigned long long self = line_thread_id ();
+
+  if (line_pending (self))
+    {
+      struct line *line = line_acquire (self);
+      if (line->len)
+	{
+	  line->buf[line->len] = '\0';
+	  line_emit ("%s", line->buf);
+	  line->len = 0;
+	}
+      line_unlock (line, self);
+    }
+}
+
+/* Emit all partial lines.  This is for _exit and abort, where the owners
+   are about to disappear; slots busy at the time are left alone.  */
+
+void
+__nvptx_line_flush_all (void)
+{
+  for (int i = 0; i < NVPTX_LINE_SLOTS; i++)
+    {
+      struct line *line = &lines[i];
+      unsigned long long owner = __atomic_load_n (&line->owner,
+						  __ATOMIC_ACQUIRE);
+
+      if (owner && !(owner & LINE_BUSY)
+	  && __atomic_compare_exchange_n (&line->owner, &owner, LINE_FLUSHING,
+					  0, __ATOMIC_ACQUIRE,
+					  __ATOMIC_RELAXED))
+	{
+	  if (line->len)
+	    {
+	      line->buf[line->len] = '\0';
+	      line_emit ("%s", line->buf);
+	    }
+	  line->len = 0;
+	  __atomic_store_n (&line->owner, 0, __ATOMIC_RELEASE);
+	}
+    }
+}
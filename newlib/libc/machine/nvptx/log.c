@@ -0,0 +1,496 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Deferred-format binary logging for printf, puts and putchar.
+
+   The CUDA-provided vprintf formats into a small FIFO that silently drops
+   output under load.  When __nvptx_log.enabled is set (by the host, or by
+   the program itself), the printf family instead appends a binary record to
+   one of NVPTX_LOG_RINGS ring buffers, selected by the SM and warp the
+   calling thread runs on.  Nothing is formatted on the device: the host
+   copies __nvptx_log out after the kernel and formats the records using the
+   format strings from the binary's string table.
+
+   Each record is a sequence of 64-bit words, which may wrap around the end
+   of the ring:
+
+     word 0     header: NVPTX_LOG_MAGIC << 32 | lap << 16 | number of words
+		in the record, the lap being the low 16 bits of the number
+		of times the ring had been gone round where the record starts
+     word 1     the format string pointer
+     word 2...  one word per argument consumed by the format, in order.
+		Integers are sign- or zero-extended according to the
+		conversion, floating point values are stored as double.
+		A '%s' argument is stored as its length N, followed by
+		N bytes of string data padded to a whole number of words
+		(at most NVPTX_LOG_MAX_STRING bytes are kept).
+
+   The header is written last, so a reader that races with the device sees
+   either a complete record or a header word that is not yet valid.  The
+   lap keeps the header of a record consumed a lap earlier, which is still
+   there when the ring has wrapped, from passing for a new one.  The
+   device only ever advances 'head' and the host only ever advances 'tail';
+   a record that doesn't fit into the free space is dropped and counted in
+   'dropped'.
+
+   The layout of __nvptx_log, and how the host finds the format strings,
+   are in machine/binlog.h.  The host-side formatter is at the end of this
+   file.
+
+   Nothing in here depends on the GPU except for the ring selection, so this
+   file also builds for the host, where it can be driven from threads.  */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include "machine/binlog.h"
+
+/* Longest record we are prepared to build: header, format, and a generous
+   number of arguments.  Formats needing more are logged truncated.  */
+#define NVPTX_LOG_MAX_RECORD 64
+
+extern int vprintf (const char *, va_list);
+
+struct __nvptx_log __nvptx_log = {
+  .enabled = 0,
+  .nrings = NVPTX_LOG_RINGS,
+  .ring_words = NVPTX_LOG_RING_WORDS
+};
+
+const char __nvptx_log_anchor[] = NVPTX_LOG_ANCHOR;
+
+/* The header of a record of NWORDS words that starts at word POS of the
+   ring, counting from the first record ever.  */
+
+static unsigned long long
+log_header (unsigned long long pos, unsigned int nwords)
+{
+  unsigned long long lap = pos / NVPTX_LOG_RING_WORDS & 0xffff;
+  return NVPTX_LOG_MAGIC << 32 | lap << 16 | nwords;
+}
+
+static struct __nvptx_log_ring *
+log_ring (void)
+{
+#ifdef __nvptx__
+  unsigned int smid, nwarpid, warpid;
+  asm ("mov.u32 %0, %%smid;" : "=r" (smid));
+  asm ("mov.u32 %0, %%nwarpid;" : "=r" (nwarpid));
+  asm volatile ("mov.u32 %0, %%warpid;" : "=r" (warpid));
+  return &__nvptx_log.rings[(smid * nwarpid + warpid) % NVPTX_LOG_RINGS];
+#else
+  return &__nvptx_log.rings[0];
+#endif
+}
+
+/* Store the string S as a length word followed by its bytes into REC,
+   which has room for AVAIL words.  Returns the number of words used.  */
+
+static unsigned int
+log_string (unsigned long long *rec, unsigned int avail, const char *s)
+{
+  if (!s)
+    s = "(null)";
+
+  size_t len = strnlen (s, NVPTX_LOG_MAX_STRING);
+  unsigned int nwords = 1 + (len + 7) / 8;
+  if (nwords > avail)
+    return 0;
+
+  rec[0] = len;
+  rec[nwords - 1] = 0;
+  memcpy (rec + 1, s, len);
+  return nwords;
+}
+
+/* Walk FMT the same way printf would and copy each argument it consumes
+   from ARGS into REC.  Returns the number of words used.  */
+
+static unsigned int
+log_args (unsigned long long *rec, unsigned int avail, const char *fmt,
+	  va_list args)
+{
+  unsigned int n = 0;
+
+  while (*fmt)
+    {
+      if (*fmt++ != '%')
+	continue;
+      if (*fmt == '%')
+	{
+	  fmt++;
+	  continue;
+	}
+
+      /* Flags.  */
+      while (*fmt && strchr ("-+ #0'", *fmt))
+	fmt++;
+
+      /* Field width and precision, either of which may be an argument.  */
+      for (int part = 0; part < 2; part++)
+	{
+	  if (part == 1)
+	    {
+	      if (*fmt != '.')
+		break;
+	      fmt++;
+	    }
+	  if (*fmt == '*')
+	    {
+	      if (n < avail)
+		rec[n++] = (long long) va_arg (args, int);
+	      fmt++;
+	    }
+	  else
+	    while (*fmt >= '0' && *fmt <= '9')
+	      fmt++;
+	}
+
+      /* Length modifiers.  */
+      int longs = 0;
+      while (*fmt && strchr ("hlLqjzt", *fmt))
+	{
+	  if (*fmt == 'l' || *fmt == 'L' || *fmt == 'q' || *fmt == 'j'
+	      || *fmt == 'z' || *fmt == 't')
+	    longs++;
+	  fmt++;
+	}
+
+      if (n >= avail)
+	break;
+
+      switch (*fmt)
+	{
+	case 'd': case 'i':
+	  rec[n++] = longs ? va_arg (args, long long)
+			   : (long long) va_arg (args, int);
+	  break;
+
+	case 'u': case 'o': case 'x': case 'X': case 'c':
+	  rec[n++] = longs ? va_arg (args, unsigned long long)
+			   : (unsigned long long) va_arg (args, unsigned int);
+	  break;
+
+	case 'e': case 'E': case 'f': case 'F':
+	case 'g': case 'G': case 'a': case 'A':
+	  {
+	    double d = va_arg (args, double);
+	    memcpy (&rec[n++], &d, sizeof d);
+	  }
+	  break;
+
+	case 'p':
+	  rec[n++] = (unsigned long long) va_arg (args, void *);
+	  break;
+
+	case 'n':
+	  /* Nothing is written yet, so there is no count to store.  */
+	  (void) va_arg (args, void *);
+	  rec[n++] = 0;
+	  break;
+
+	case 's':
+	  {
+	    unsigned int used = log_string (rec + n, avail - n,
+					    va_arg (args, const char *));
+	    if (!used)
+	      return n;
+	    n += used;
+	  }
+	  break;
+
+	case '\0':
+	  return n;
+	}
+      fmt++;
+    }
+
+  return n;
+}
+
+/* Append a record for FMT and ARGS to the current warp's ring.  Returns 0,
+   or -1 if the record was dropped.  Deferred output has no length to
+   report.  */
+
+int
+__nvptx_log_vprintf (const char *fmt, va_list args)
+{
+  unsigned long long rec[NVPTX_LOG_MAX_RECORD];
+  unsigned int nwords;
+
+  /* Stored here rather than in the initializer, which can't hold an
+     address as an integer.  */
+  if (!__nvptx_log.anchor)
+    __nvptx_log.anchor = (uintptr_t) __nvptx_log_anchor;
+
+  rec[1] = (uintptr_t) fmt;
+  nwords = 2 + log_args (rec + 2, NVPTX_LOG_MAX_RECORD - 2, fmt, args);
+
+  struct __nvptx_log_ring *ring = log_ring ();
+
+  /* Reserve NWORDS words, unless that would overwrite data the host
+     hasn't consumed yet.  */
+  unsigned long long head = __atomic_load_n (&ring->head, __ATOMIC_RELAXED);
+  do
+    {
+      unsigned long long tail = __atomic_load_n (&ring->tail,
+						 __ATOMIC_ACQUIRE);
+      if (head + nwords - tail > NVPTX_LOG_RING_WORDS)
+	{
+	  __atomic_fetch_add (&ring->dropped, 1, __ATOMIC_RELAXED);
+	  return -1;
+	}
+    }
+  while (!__atomic_compare_exchange_n (&ring->head, &head, head + nwords, 1,
+				       __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+  for (unsigned int i = 1; i < nwords; i++)
+    ring->words[(head + i) % NVPTX_LOG_RING_WORDS] = rec[i];
+
+  __atomic_store_n (&ring->words[head % NVPTX_LOG_RING_WORDS],
+		    log_header (head, nwords), __ATOMIC_RELEASE);
+  return 0;
+}
+
+/* The printf family formats through here.  */
+
+int
+__nvptx_vprintf (const char *fmt, va_list args)
+{
+  if (__nvptx_log.enabled)
+    return __nvptx_log_vprintf (fmt, args);
+  return vprintf (fmt, args);
+}
+
+#ifndef __nvptx__
+/* The host-side formatter.  */
+
+/* Append the LEN bytes at TEXT to the conversion specification SPEC, which
+   holds *USED of SPEC_SIZE bytes.  Returns 0, or -1 if they don't fit.  */
+
+static int
+spec_append (char *spec, size_t spec_size, size_t *used, const char *text,
+	     size_t len)
+{
+  if (*used + len >= spec_size)
+    return -1;
+  memcpy (spec + *used, text, len);
+  *used += len;
+  spec[*used] = '\0';
+  return 0;
+}
+
+/* Print FMT with the NARGS argument words at ARGS, which log_args stored.
+   Length modifiers are dropped from each conversion, and integers printed
+   at full width, since the words hold them sign- or zero-extended.  */
+
+static void
+log_format_record (FILE *out, const char *fmt,
+		   const unsigned long long *args, unsigned int nargs)
+{
+  unsigned int n = 0;
+
+  while (*fmt)
+    {
+      if (*fmt != '%')
+	{
+	  fputc (*fmt++, out);
+	  continue;
+	}
+      if (fmt[1] == '%')
+	{
+	  fputc ('%', out);
+	  fmt += 2;
+	  continue;
+	}
+
+      const char *start = fmt++;
+      char spec[64];
+      size_t used = 0;
+      int bad = spec_append (spec, sizeof spec, &used, "%", 1);
+
+      while (*fmt && strchr ("-+ #0'", *fmt))
+	bad |= spec_append (spec, sizeof spec, &used, fmt++, 1);
+
+      for (int part = 0; part < 2; part++)
+	{
+	  if (part == 1)
+	    {
+	      if (*fmt != '.')
+		break;
+	      bad |= spec_append (spec, sizeof spec, &used, fmt++, 1);
+	    }
+	  if (*fmt == '*')
+	    {
+	      if (n >= nargs)
+		return;
+	      char num[16];
+	      int len = snprintf (num, sizeof num, "%d", (int) args[n++]);
+	      bad |= spec_append (spec, sizeof spec, &used, num, len);
+	      fmt++;
+	    }
+	  else
+	    while (*fmt >= '0' && *fmt <= '9')
+	      bad |= spec_append (spec, sizeof spec, &used, fmt++, 1);
+	}
+
+      while (*fmt && strchr ("hlLqjzt", *fmt))
+	fmt++;
+
+      char conv = *fmt;
+      if (!conv)
+	return;
+      fmt++;
+
+      /* The device stops storing arguments when the record is full.  */
+      if (n >= nargs && strchr ("diuoxXcpeEfFgGaAs", conv))
+	return;
+
+      if (bad)
+	{
+	  fwrite (start, 1, fmt - start, out);
+	  if (conv != 'n' && strchr ("diuoxXcpeEfFgGaAs", conv))
+	    n++;
+	  continue;
+	}
+
+      switch (conv)
+	{
+	case 'd': case 'i':
+	case 'u': case 'o': case 'x': case 'X':
+	  spec_append (spec, sizeof spec, &used, "ll", 2);
+	  spec_append (spec, sizeof spec, &used, &conv, 1);
+	  fprintf (out, spec, args[n++]);
+	  break;
+
+	case 'c':
+	  spec_append (spec, sizeof spec, &used, &conv, 1);
+	  fprintf (out, spec, (int) args[n++]);
+	  break;
+
+	case 'e': case 'E': case 'f': case 'F':
+	case 'g': case 'G': case 'a': case 'A':
+	  {
+	    double d;
+	    memcpy (&d, &args[n++], sizeof d);
+	    spec_append (spec, sizeof spec, &used, &conv, 1);
+	    fprintf (out, spec, d);
+	  }
+	  break;
+
+	case 'p':
+	  spec_append (spec, sizeof spec, &used, &conv, 1);
+	  fprintf (out, spec, (void *) (uintptr_t) args[n++]);
+	  break;
+
+	case 'n':
+	  n++;
+	  break;
+
+	case 's':
+	  {
+	    char str[NVPTX_LOG_MAX_STRING + 1];
+	    size_t len = args[n];
+	    unsigned int nwords = 1 + (len + 7) / 8;
+	    if (len > NVPTX_LOG_MAX_STRING || n + nwords > nargs)
+	      return;
+	    memcpy (str, &args[n + 1], len);
+	    str[len] = '\0';
+	    n += nwords;
+	    spec_append (spec, sizeof spec, &used, &conv, 1);
+	    fprintf (out, spec, str);
+	  }
+	  break;
+
+	default:
+	  fwrite (start, 1, fmt - start, out);
+	  break;
+	}
+    }
+}
+
+long
+__nvptx_log_format (struct __nvptx_log *log, __nvptx_log_resolver *resolve,
+		    void *ctx, FILE *out)
+{
+  long nrecords = 0;
+
+  if (log->nrings != NVPTX_LOG_RINGS || log->ring_words != NVPTX_LOG_RING_WORDS)
+    return -1;
+
+  for (unsigned int r = 0; r < NVPTX_LOG_RINGS; r++)
+    {
+      struct __nvptx_log_ring *ring = &log->rings[r];
+
+      while (ring->tail < ring->head)
+	{
+	  unsigned long long rec[NVPTX_LOG_MAX_RECORD];
+	  unsigned long long header
+	    = ring->words[ring->tail % NVPTX_LOG_RING_WORDS];
+	  unsigned int nwords = header & 0xffff;
+
+	  /* A record whose header isn't valid yet is still being written;
+	     one from an earlier lap is what it is being written over.  */
+	  if (header != log_header (ring->tail, nwords) || nwords < 2
+	      || nwords > NVPTX_LOG_MAX_RECORD)
+	    break;
+
+	  for (unsigned int i = 0; i < nwords; i++)
+	    rec[i] = ring->words[(ring->tail + i) % NVPTX_LOG_RING_WORDS];
+
+	  const char *fmt = resolve (rec[1], ctx);
+	  if (!fmt)
+	    return -1;
+
+	  log_format_record (out, fmt, rec + 2, nwords - 2);
+	  ring->tail += nwords;
+	  nrecords++;
+	}
+    }
+  return nrecords;
+}
+
+int
+__nvptx_log_image_init (struct __nvptx_log_image *image, const void *data,
+			size_t size, unsigned long long anchor)
+{
+  const char *bytes = (const char *) data;
+  size_t len = sizeof NVPTX_LOG_ANCHOR;
+
+  for (size_t i = 0; i + len <= size; i++)
+    if (!memcmp (bytes + i, NVPTX_LOG_ANCHOR, len))
+      {
+	image->data = bytes;
+	image->size = size;
+	image->anchor = anchor;
+	image->anchor_offset = i;
+	return 0;
+      }
+  return -1;
+}
+
+const char *
+__nvptx_log_image_resolve (unsigned long long addr, void *ctx)
+{
+  struct __nvptx_log_image *image = (struct __nvptx_log_image *) ctx;
+  unsigned long long offset = addr - image->anchor + image->anchor_offset;
+
+  /* The string has to end inside the image.  */
+  if (offset >= image->size
+      || !memchr (image->data + offset, '\0', image->size - offset))
+    return NULL;
+  return image->data + offset;
+}
+#endif
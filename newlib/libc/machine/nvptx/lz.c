@@ -0,0 +1,206 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* A small LZ77 block codec for compressing vramfs files.
+
+   The compressed form is a sequence of sequences, each of which is
+
+     token	high nibble: literal count, low nibble: match length - 4;
+		a nibble of 15 is continued by extension bytes
+     ext...	literal count extension: bytes added on until one is < 255
+     literals
+     offset	2 bytes, little-endian, distance back to the match (>= 1)
+     ext...	match length extension, as for the literal count
+
+   The last sequence ends after its literals and has no match.  Matches are
+   found greedily through a hash table of 4-byte prefixes.  The codec uses
+   only plain C, so it can be built and exercised on the host.  */
+
+#include <string.h>
+#include "lz.h"
+
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+
+static unsigned int
+lz_load32 (const unsigned char *p)
+{
+  return p[0] | p[1] << 8 | p[2] << 16 | (unsigned int) p[3] << 24;
+}
+
+static unsigned int
+lz_hash (unsigned int seq)
+{
+  return (seq * 2654435761u) >> 20;	/* 12 bits, LZ_WORK_ELEMS entries.  */
+}
+
+/* Encode LEN as the continuation of a length nibble.  */
+
+static unsigned char *
+lz_put_length (unsigned char *op, size_t len)
+{
+  for (; len >= 255; len -= 255)
+    *op++ = 255;
+  *op++ = len;
+  return op;
+}
+
+/* Append one sequence to *OP_REF.  MLEN is 0 for the last sequence.
+   Returns 0 if it doesn't fit before OEND.  */
+
+static int
+lz_put_sequence (unsigned char **op_ref, unsigned char *oend,
+		 const unsigned char *lit, size_t nlit, size_t offset,
+		 size_t mlen)
+{
+  unsigned char *op = *op_ref;
+  size_t need = 1 + nlit / 255 + 1 + nlit + 2 + mlen / 255 + 1;
+
+  if (need > (size_t) (oend - op))
+    return 0;
+
+  unsigned char *token = op++;
+  *token = (nlit < 15 ? nlit : 15) << 4;
+  if (nlit >= 15)
+    op = lz_put_length (op, nlit - 15);
+  memcpy (op, lit, nlit);
+  op += nlit;
+
+  if (mlen)
+    {
+      mlen -= LZ_MIN_MATCH;
+      *token |= mlen < 15 ? mlen : 15;
+      *op++ = offset;
+      *op++ = offset >> 8;
+      if (mlen >= 15)
+	op = lz_put_length (op, mlen - 15);
+    }
+
+  *op_ref = op;
+  return 1;
+}
+
+/* Compress LEN bytes of SRC into DST, which has room for CAP bytes.  TABLE
+   is a work area of LZ_WORK_ELEMS elements.  Returns the compressed size,
+   or 0 if the input is too large or the output doesn't fit.  */
+
+size_t
+__nvptx_lz_compress (const void *src, size_t len, void *dst, size_t cap,
+		     unsigned short *table)
+{
+  const unsigned char *in = src;
+  const unsigned char *ip = in, *anchor = in, *end = in + len;
+  unsigned char *op = dst, *oend = op + cap;
+
+  if (len > LZ_MAX_INPUT)
+    return 0;
+
+  memset (table, 0, LZ_WORK_ELEMS * sizeof *table);
+
+  while (ip + LZ_MIN_MATCH <= end)
+    {
+      unsigned int seq = lz_load32 (ip);
+      unsigned int h = lz_hash (seq);
+      const unsigned char *ref = in + table[h];
+      table[h] = ip - in;
+
+      if (ref < ip && ip - ref <= LZ_MAX_OFFSET && lz_load32 (ref) == seq)
+	{
+	  const unsigned char *m = ip + LZ_MIN_MATCH;
+	  const unsigned char *r = ref + LZ_MIN_MATCH;
+	  while (m < end && *m == *r)
+	    m++, r++;
+
+	  if (!lz_put_sequence (&op, oend, anchor, ip - anchor, ip - ref,
+				m - ip))
+	    return 0;
+	  ip = anchor = m;
+	}
+      else
+	ip++;
+    }
+
+  if (!lz_put_sequence (&op, oend, anchor, end - anchor, 0, 0))
+    return 0;
+  return op - (unsigned char *) dst;
+}
+
+/* Read the continuation of a length nibble into *LEN_REF.  */
+
+static const unsigned char *
+lz_get_length (const unsigned char *ip, const unsigned char *iend,
+	       size_t *len_ref)
+{
+  unsigned char b;
+
+  do
+    {
+      if (ip == iend)
+	return NULL;
+      b = *ip++;
+      *len_ref += b;
+    }
+  while (b == 255);
+  return ip;
+}
+
+/* Decompress LEN bytes of SRC into DST, which has room for CAP bytes.
+   Returns the decompressed size, or (size_t) -1 if the input is corrupt or
+   the output doesn't fit.  */
+
+size_t
+__nvptx_lz_decompress (const void *src, size_t len, void *dst, size_t cap)
+{
+  const unsigned char *ip = src, *iend = ip + len;
+  unsigned char *op = dst, *oend = op + cap;
+
+  while (ip < iend)
+    {
+      unsigned char token = *ip++;
+
+      size_t nlit = token >> 4;
+      if (nlit == 15 && !(ip = lz_get_length (ip, iend, &nlit)))
+	return (size_t) -1;
+      if (nlit > (size_t) (iend - ip) || nlit > (size_t) (oend - op))
+	return (size_t) -1;
+      memcpy (op, ip, nlit);
+      ip += nlit;
+      op += nlit;
+
+      if (ip == iend)
+	break;
+
+      if (iend - ip < 2)
+	return (size_t) -1;
+      size_t offset = ip[0] | ip[1] << 8;
+      ip += 2;
+      if (offset == 0 || offset > (size_t) (op - (unsigned char *) dst))
+	return (size_t) -1;
+
+      size_t mlen = token & 15;
+      if (mlen == 15 && !(ip = lz_get_length (ip, iend, &mlen)))
+	return (size_t) -1;
+      mlen += LZ_MIN_MATCH;
+      if (mlen > (size_t) (oend - op))
+	return (size_t) -1;
+
+      /* Byte by byte, as the match may overlap what it produces.  */
+      const unsigned char *ref = op - offset;
+      while (mlen--)
+	*op++ = *ref++;
+    }
+
+  return op - (unsigned char *) dst;
+}
@@ -0,0 +1,37 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Internal interface of the LZ block codec used by vramfs; see lz.c.  */
+
+#ifndef _NVPTX_LZ_H_
+#define _NVPTX_LZ_H_
+
+#include <stddef.h>
+
+/* Largest input __nvptx_lz_compress accepts.  */
+#define LZ_MAX_INPUT 65536
+
+/* Number of unsigned short elements of the work area that
+   __nvptx_lz_compress needs.  It is too large for the stack.  */
+#define LZ_WORK_ELEMS 4096
+
+/* Worst-case compressed size of LEN bytes of input.  */
+#define LZ_BOUND(len) ((len) + (len) / 255 + 16)
+
+extern size_t __nvptx_lz_compress (const void *, size_t, void *, size_t,
+				   unsigned short *);
+extern size_t __nvptx_lz_decompress (const void *, size_t, void *, size_t);
+
+#endif /* _NVPTX_LZ_H_ */
@@ -0,0 +1,122 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Deferred-format binary logging for the printf family; see log.c for the
+   record format.  This is the layout of the device global __nvptx_log,
+   which the host copies out after the kernel, and the host-side formatter
+   that turns the records back into text.
+
+   Records refer to their format strings by device address.  To find them
+   on the host, the log carries the device address of __nvptx_log_anchor,
+   a string that sits among the format strings of the device image: a
+   format at device address A is found A - anchor bytes from the anchor
+   in a host copy of the image's string data.
+
+   Strings passed for %s are copied into the record, but only up to
+   NVPTX_LOG_MAX_STRING (128) bytes of each; the rest is lost.  Use
+   ordinary output for longer strings.  */
+
+#ifndef _MACHINE_BINLOG_H_
+#define _MACHINE_BINLOG_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef NVPTX_LOG_RINGS
+#define NVPTX_LOG_RINGS 32
+#endif
+
+#ifndef NVPTX_LOG_RING_WORDS
+#define NVPTX_LOG_RING_WORDS 2048
+#endif
+
+#ifndef NVPTX_LOG_MAX_STRING
+#define NVPTX_LOG_MAX_STRING 128
+#endif
+
+#define NVPTX_LOG_MAGIC 0x4e564c47ull	/* "NVLG" */
+
+/* The text of __nvptx_log_anchor.  */
+#define NVPTX_LOG_ANCHOR "\001nvptx-log-anchor\001"
+
+struct __nvptx_log_ring
+{
+  unsigned long long head;	/* Words ever reserved by the device.  */
+  unsigned long long tail;	/* Words ever consumed by the host.  */
+  unsigned long long dropped;	/* Records lost because the ring was full.  */
+  unsigned long long words[NVPTX_LOG_RING_WORDS];
+};
+
+struct __nvptx_log
+{
+  int enabled;			/* Non-zero selects binary logging.  */
+  unsigned int nrings;		/* Layout information for the host.  */
+  unsigned int ring_words;
+  unsigned int reserved;
+  unsigned long long anchor;	/* Device address of __nvptx_log_anchor.  */
+  struct __nvptx_log_ring rings[NVPTX_LOG_RINGS];
+};
+
+extern struct __nvptx_log __nvptx_log;
+extern const char __nvptx_log_anchor[];
+
+#ifndef __nvptx__
+#include <stdio.h>
+
+/* Return the host copy of the nul-terminated string at device address
+   ADDR, or NULL if it isn't known.  */
+typedef const char *__nvptx_log_resolver (unsigned long long __addr,
+					  void *__ctx);
+
+/* Format the records of all rings of LOG, a host copy of __nvptx_log, to
+   OUT, and mark them consumed by advancing each ring's tail.  Format
+   strings are looked up with RESOLVE.  Records are written ring by ring,
+   so output from different warps isn't interleaved in time order.
+   Returns the number of records formatted, or -1 if a record is corrupt
+   or its format can't be resolved; formatting stops there.  */
+extern long __nvptx_log_format (struct __nvptx_log *__log,
+				__nvptx_log_resolver *__resolve,
+				void *__ctx, FILE *__out);
+
+/* A host copy of the string data of a device image, for
+   __nvptx_log_image_resolve.  */
+struct __nvptx_log_image
+{
+  const char *data;
+  size_t size;
+  unsigned long long anchor;	/* The anchor field of the log.  */
+  size_t anchor_offset;		/* Where the anchor is in DATA.  */
+};
+
+/* Fill in IMAGE for the SIZE bytes at DATA and the anchor address ANCHOR
+   taken from the log.  Returns 0, or -1 if DATA doesn't contain the
+   anchor.  */
+extern int __nvptx_log_image_init (struct __nvptx_log_image *__image,
+				   const void *__data, size_t __size,
+				   unsigned long long __anchor);
+
+/* A resolver for __nvptx_log_format; CTX is a struct __nvptx_log_image.  */
+extern const char *__nvptx_log_image_resolve (unsigned long long __addr,
+					      void *__ctx);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_BINLOG_H_ */
@@ -0,0 +1,46 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Time keeping of the nvptx clock, clock_gettime and gettimeofday.
+
+   Time is counted by %globaltimer where the target has it, and by %clock64
+   cycles otherwise.  The host may fill in __nvptx_clock before launch; see
+   clock.c for how the fields are used.  */
+
+#ifndef _MACHINE_CLOCK_H_
+#define _MACHINE_CLOCK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct __nvptx_clock
+{
+  long long realtime_offset;		/* Nanoseconds from the epoch to timer zero.  */
+  unsigned long long clock64_hz;	/* %clock64 cycles per second, or 0.  */
+};
+
+extern struct __nvptx_clock __nvptx_clock;
+
+/* Measure the %clock64 rate against %globaltimer, spinning for about a
+   millisecond, and store it in __nvptx_clock.clock64_hz.  Returns the
+   rate, or 0 if it couldn't be measured.  */
+extern unsigned long long __nvptx_clock_calibrate (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_CLOCK_H_ */
@@ -0,0 +1,45 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Pools of freed heap blocks for the nvptx malloc and friends.
+
+   Small blocks that are freed are kept for reuse instead of going back to
+   the CUDA heap, which is slow.  Blocks come back dirty; calloc zeroes a
+   dirty block as it hands it out, unless it finds one that is already
+   clean.  A program that has idle time, such as a warp that waits for the
+   others, can spend it making pooled blocks clean, so that the calloc
+   calls that follow don't have to zero anything.  */
+
+#ifndef _MACHINE_HEAPPOOL_H_
+#define _MACHINE_HEAPPOOL_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Zero dirty pooled blocks, up to about MAX_BYTES worth of them (all of
+   them if MAX_BYTES is 0), and return how many bytes were zeroed.  */
+extern size_t __nvptx_heap_scrub (size_t __max_bytes);
+
+/* Give all pooled blocks back to the CUDA heap.  */
+extern void __nvptx_heap_drain (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_HEAPPOOL_H_ */
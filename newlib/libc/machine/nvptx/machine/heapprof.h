@@ -0,0 +1,85 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Heap profiling for the nvptx malloc and friends.
+
+   A library built with NVPTX_HEAP_PROFILE counts every allocation and
+   free; see heapprof.c.  The counts are printed by _exit, together with
+   the call sites of the blocks that were never freed, and can be read
+   at any time with __nvptx_heap_stats.  */
+
+#ifndef _MACHINE_HEAPPROF_H_
+#define _MACHINE_HEAPPROF_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of size classes in the allocation histogram.  Class 0 counts
+   allocations of up to 16 bytes, class I those of up to 16 << I bytes,
+   and the last class all larger ones.  */
+#define NVPTX_HEAP_PROF_CLASSES 20
+
+struct __nvptx_heap_stats
+{
+  unsigned long long allocs;		/* Blocks handed out.  */
+  unsigned long long frees;		/* Blocks given back.  */
+  unsigned long long failures;		/* Allocations the heap refused.  */
+  unsigned long long live_bytes;	/* Bytes in blocks not yet freed.  */
+  unsigned long long peak_bytes;	/* Highest live_bytes seen.  */
+  unsigned long long realloc_copied;	/* Bytes moved by realloc.  */
+  unsigned long long classes[NVPTX_HEAP_PROF_CLASSES];
+};
+
+/* Fill in STATS.  Returns 0, or -1 if the library was built without
+   NVPTX_HEAP_PROFILE.  */
+extern int __nvptx_heap_stats (struct __nvptx_heap_stats *__stats);
+
+/* Print the counts and the call sites of all blocks not yet freed.  This
+   is what _exit does; it prints nothing without NVPTX_HEAP_PROFILE.  */
+extern void __nvptx_heap_report (void);
+
+/* Allocation functions that record FILE and LINE as the call site of the
+   block.  Code compiled with NVPTX_HEAP_SITES defined gets malloc, calloc,
+   realloc, memalign and aligned_alloc mapped to these; blocks allocated
+   otherwise are reported without a call site.  */
+extern void *__nvptx_malloc_at (size_t __size, const char *__file,
+				int __line);
+extern void *__nvptx_calloc_at (size_t __nmemb, size_t __size,
+				const char *__file, int __line);
+extern void *__nvptx_realloc_at (void *__ptr, size_t __size,
+				 const char *__file, int __line);
+extern void *__nvptx_memalign_at (size_t __align, size_t __size,
+				  const char *__file, int __line);
+
+#ifdef NVPTX_HEAP_SITES
+#define malloc(size) __nvptx_malloc_at ((size), __FILE__, __LINE__)
+#define calloc(nmemb, size) \
+  __nvptx_calloc_at ((nmemb), (size), __FILE__, __LINE__)
+#define realloc(ptr, size) \
+  __nvptx_realloc_at ((ptr), (size), __FILE__, __LINE__)
+#define memalign(align, size) \
+  __nvptx_memalign_at ((align), (size), __FILE__, __LINE__)
+#define aligned_alloc(align, size) \
+  __nvptx_memalign_at ((align), (size), __FILE__, __LINE__)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_HEAPPROF_H_ */
@@ -0,0 +1,323 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Extensions of the nvptx in-memory file system (vramfs) that go beyond the
+   POSIX system calls, and the layout of the device globals that host-side
+   tools read and write through the driver API.
+
+   What is available depends on the build profile (see Makefile.inc).  The
+   default profile, FULL, has everything declared here.  BASIC builds
+   without file compression and deduplication: the tunables and statistics
+   of both exist, but files are never compressed or deduplicated.  STDIO
+   builds no file system at all, only fd 0, 1 and 2, and of this header
+   only the stdin ring (__vramfs_stdin) applies.  */
+
+#ifndef _MACHINE_VRAMFS_H_
+#define _MACHINE_VRAMFS_H_
+
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef VRAMFS_CAPTURE_SIZE
+#define VRAMFS_CAPTURE_SIZE 65536
+#endif
+
+#ifndef VRAMFS_CAPTURE_WATERMARK
+#define VRAMFS_CAPTURE_WATERMARK (VRAMFS_CAPTURE_SIZE / 4 * 3)
+#endif
+
+/* Captured standard output and standard error (global __vramfs_capture).
+
+   While capturing, fd 1 and fd 2 are backed by the vramfs entries
+   /dev/stdout.capture and /dev/stderr.capture, whose data lives in here
+   rather than on the device heap, so the host can fetch both streams with a
+   single copy of this object.  size[] counts every byte written; only the
+   first VRAMFS_CAPTURE_SIZE of them are kept, the rest go out through printf
+   and are counted in overflow[].  ready is set once either stream passes
+   VRAMFS_CAPTURE_WATERMARK.  capacity and watermark are filled in when
+   capturing starts; the object is otherwise zero-initialized.  The host
+   may reset size[], overflow[] and ready to 0 between kernel launches
+   after copying the data out.  Setting enabled before the launch is
+   equivalent to calling __vramfs_capture_stdio (1) on the device.  */
+
+struct __vramfs_capture
+{
+  int enabled;
+  int ready;
+  unsigned int capacity;
+  unsigned int watermark;
+  unsigned long long size[2];
+  unsigned long long overflow[2];
+  char data[2][VRAMFS_CAPTURE_SIZE];
+};
+
+extern struct __vramfs_capture __vramfs_capture;
+
+/* Redirect fd 1 and fd 2 into vramfs (ENABLE non-zero) or back to printf.
+   Returns 0, or -1 with errno set if the capture entries can't be created.  */
+extern int __vramfs_capture_stdio (int __enable);
+
+#ifndef VRAMFS_STDIN_SIZE
+#define VRAMFS_STDIN_SIZE 65536
+#endif
+
+/* Standard input (global __vramfs_stdin).
+
+   While enabled is set, fd 0 reads from a ring buffer that the host fills
+   while the kernel runs, with a single writer (the host) and any number of
+   readers (device threads).  head counts every byte ever written and tail
+   every byte ever read; byte N lives in data[N % VRAMFS_STDIN_SIZE].  The
+   writer stores bytes in data[] only up to tail + VRAMFS_STDIN_SIZE, then
+   advances head; __vramfs_stdin_push does that for a host that can map
+   this object.  When there is no more input, the writer sets closed, after
+   which reads that find the ring empty return 0 (end of file).
+
+   A read returns whatever is available, up to the count it was given.
+   If nothing is, it waits for input, unless nonblock is set, in which case
+   it fails with EAGAIN.  With enabled clear (the default), fd 0 is always
+   at end of file.  The object is zero-initialized.  */
+
+struct __vramfs_stdin
+{
+  int enabled;
+  int nonblock;
+  int closed;
+  int reserved;
+  unsigned long long head;
+  unsigned long long tail;
+  char data[VRAMFS_STDIN_SIZE];
+};
+
+extern struct __vramfs_stdin __vramfs_stdin;
+
+/* Writer side of the stdin ring: copy as much of the LEN bytes at BUF into
+   IN as there is room for, and return how many that was.  */
+
+static __inline__ size_t
+__vramfs_stdin_push (struct __vramfs_stdin *__in, const void *__buf,
+		     size_t __len)
+{
+  unsigned long long __head = __in->head;
+  unsigned long long __tail = __atomic_load_n (&__in->tail, __ATOMIC_ACQUIRE);
+  size_t __room = VRAMFS_STDIN_SIZE - (size_t) (__head - __tail);
+  size_t __i;
+
+  if (__len > __room)
+    __len = __room;
+  for (__i = 0; __i < __len; __i++)
+    __in->data[(__head + __i) % VRAMFS_STDIN_SIZE]
+      = ((const char *) __buf)[__i];
+  __atomic_store_n (&__in->head, __head + __len, __ATOMIC_RELEASE);
+  return __len;
+}
+
+/* Layout of the blob produced by __vramfs_export.  The blob starts with a
+   struct __vramfs_export_header, followed by nentries records.  Each record
+   is a struct __vramfs_export_entry, followed by name_len bytes of the
+   file's absolute path (such as "/out/case17/result.txt") and a
+   terminating nul, padded to a multiple of 8 bytes, followed by
+   size bytes of file data, again padded to a multiple of 8 bytes.  A file
+   with several names (see link) has a record for each of them.  All
+   fields are in the device's (little-endian) byte order.  */
+
+#define VRAMFS_EXPORT_MAGIC 0x53465256u	/* "VRFS" */
+#define VRAMFS_EXPORT_VERSION 1
+
+struct __vramfs_export_header
+{
+  unsigned int magic;
+  unsigned int version;
+  unsigned int nentries;
+  unsigned int reserved;
+  unsigned long long total_size;	/* Including this header.  */
+};
+
+struct __vramfs_export_entry
+{
+  unsigned long long size;		/* File data bytes.  */
+  unsigned int name_len;		/* Path bytes, without the nul.  */
+  unsigned int reserved;
+};
+
+/* Serialize all files whose path starts with PREFIX (all files if PREFIX
+   is NULL; a PREFIX without a leading '/' is taken relative to the root)
+   into BUF, which has room for SIZE bytes.  Like snprintf, this returns
+   the size of the complete blob, and only writes to BUF if it fits.  BUF
+   should be memory the host can copy from, such as a device global or a
+   buffer allocated by the host; it must be 8-byte aligned.  Returns -1
+   with errno set to ENOMEM if a compressed file can't be decompressed
+   into BUF.  */
+extern ssize_t __vramfs_export (void *__buf, size_t __size,
+				const char *__prefix);
+
+#ifndef __nvptx__
+/* On the host: write the files of the export blob of SIZE bytes at BLOB,
+   a host copy, below the host directory DIR, creating directories as
+   needed and replacing files that are there.  Returns 0, or -1 with errno
+   set, to EINVAL if the blob is malformed or has a path that isn't
+   absolute or has "." or ".." components.  */
+extern int __vramfs_unpack (const void *__blob, size_t __size,
+			    const char *__dir);
+#endif
+
+/* Layout of the blob produced by __vramfs_delta.  The blob starts with a
+   struct __vramfs_delta_header, followed by nremovals removal records,
+   followed by nentries file records.  A removal record is a struct
+   __vramfs_delta_removal followed by a path as in an export record; the
+   file or directory of that path was removed or renamed after generation
+   since.  There is a file record for each name of a regular file that was
+   modified, created, linked or renamed (or whose directory was renamed)
+   after generation since.  Each is a struct __vramfs_delta_entry, followed
+   by the file path as in an export record, followed by nranges struct
+   __vramfs_delta_range, followed by the data of all ranges back to back,
+   padded to a multiple of 8 bytes.  A name that is new since then has all
+   of its data in ranges.  To apply a delta, the host first removes the
+   paths of the removal records, with everything below them, then truncates
+   or extends each recorded file to size and writes its ranges.  Passing
+   the generation of a delta as since of the next one yields only what
+   changed in between.  If __vramfs_reset ran after generation since, or
+   removals since then were too many to remember, the delta has
+   VRAMFS_DELTA_RESYNC set in flags, no removal records and every file in
+   full: the host removes all files it holds before applying it.  */
+
+#define VRAMFS_DELTA_MAGIC 0x4c445256u	/* "VRDL" */
+#define VRAMFS_DELTA_VERSION 3
+
+/* Flags of struct __vramfs_delta_header.  */
+#define VRAMFS_DELTA_RESYNC 0x1
+
+struct __vramfs_delta_header
+{
+  unsigned int magic;
+  unsigned int version;
+  unsigned int nentries;
+  unsigned int flags;			/* VRAMFS_DELTA_*.  */
+  unsigned long long since;
+  unsigned long long generation;	/* Current generation.  */
+  unsigned long long total_size;	/* Including this header.  */
+  unsigned int nremovals;
+  unsigned int reserved;
+};
+
+struct __vramfs_delta_removal
+{
+  unsigned int name_len;		/* Path bytes, without the nul.  */
+  unsigned int reserved;
+};
+
+struct __vramfs_delta_entry
+{
+  unsigned long long size;		/* Current file size.  */
+  unsigned int name_len;
+  unsigned int nranges;
+};
+
+struct __vramfs_delta_range
+{
+  unsigned long long offset;
+  unsigned long long length;
+};
+
+/* Return the current file system generation.  */
+extern unsigned long long __vramfs_generation (void);
+
+/* Serialize everything modified after generation SINCE into BUF, which has
+   room for SIZE bytes.  Returns the size of the complete delta, and only
+   writes to BUF if it fits; see __vramfs_export.  */
+extern ssize_t __vramfs_delta (void *__buf, size_t __size,
+			       unsigned long long __since);
+
+#ifndef __nvptx__
+/* On the host: apply the delta blob of SIZE bytes at BLOB, a host copy, to
+   the host directory DIR, which holds what __vramfs_unpack or earlier
+   deltas put there.  Returns 0, or -1 with errno set; see
+   __vramfs_unpack.  */
+extern int __vramfs_apply_delta (const void *__blob, size_t __size,
+				 const char *__dir);
+#endif
+
+/* Discard all regular files and close all file descriptors except 0, 1 and
+   2, in constant time: old files and descriptors are invalidated by
+   advancing an epoch and reclaimed lazily, and the data buffers of old
+   files are reused by new ones.  Directories created since startup are
+   discarded the same way.  Files named in the NULL-terminated array KEEP
+   (which may itself be NULL) survive the reset with their contents, along
+   with the directories leading up to them, and with all of their other
+   names; naming a directory in KEEP keeps the directory, but not the files
+   in it.  */
+extern void __vramfs_reset (const char *const *__keep);
+
+/* Regular files of at least this many bytes are compressed when they are
+   closed, and all closed files are candidates for compression when the
+   device heap runs out.  Compressed files are decompressed block by block
+   as they are read, and as a whole before they are written to.  0 (the
+   default) disables compression.  */
+extern size_t __vramfs_compress_threshold;
+
+struct __vramfs_compress_stats
+{
+  unsigned long long files;		/* Files compressed.  */
+  unsigned long long bytes_in;		/* Their uncompressed size.  */
+  unsigned long long bytes_out;		/* Their compressed size.  */
+  unsigned long long compress_cycles;	/* %clock64 cycles compressing.  */
+  unsigned long long blocks_inflated;	/* Blocks decompressed for reads.  */
+  unsigned long long files_inflated;	/* Files decompressed for writes.  */
+  unsigned long long decompress_cycles;	/* %clock64 cycles decompressing.  */
+};
+
+extern struct __vramfs_compress_stats __vramfs_compress_stats;
+
+/* When non-zero, regular files are deduplicated when they are closed: their
+   data is split into 4 KiB blocks, identical blocks (by hash, then by
+   content) are stored only once and shared by reference count, and a file
+   that is written to again gets a private copy of its data first.  A
+   deduplicated file is not compressed in addition.  */
+extern int __vramfs_dedup_enabled;
+
+struct __vramfs_dedup_stats
+{
+  unsigned long long logical_bytes;	/* Data of deduplicated files.  */
+  unsigned long long stored_bytes;	/* Unique blocks backing it.  */
+  unsigned long long blocks_shared;	/* Blocks found already stored.  */
+  unsigned long long hash_cycles;	/* %clock64 cycles deduplicating.  */
+};
+
+/* The dedup ratio is logical_bytes / stored_bytes.  */
+extern struct __vramfs_dedup_stats __vramfs_dedup_stats;
+
+/* Copy up to LEN bytes between two regular files, as on Linux; newlib's
+   <unistd.h> doesn't declare it.  The data is copied once, from file to
+   file.  A copy of the whole of a deduplicated file over the whole of
+   another one takes references to its blocks instead; with
+   __vramfs_dedup_enabled set, the source is deduplicated for that first.  */
+extern ssize_t copy_file_range (int __fd_in, off_t *__off_in, int __fd_out,
+				off_t *__off_out, size_t __len,
+				unsigned int __flags);
+
+/* File descriptors other than 0, 1 and 2 are private to the team (thread
+   block) that opened them: every team has its own table of them, so the
+   same fd number refers to different files in different teams.  Code that
+   passes fds between teams can set this to non-zero, before any files are
+   opened, to make all teams share a single table instead.  */
+extern int __vramfs_shared_fds;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MACHINE_VRAMFS_H_ */
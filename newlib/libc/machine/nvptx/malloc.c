@@ -13,17 +13,50 @@
  * they apply.
  */
 
+#include <stdint.h>
 #include <stdlib.h>
+#include "machine/heapprof.h"
+#include "machine/heappool.h"
+#include "heap.h"
 
 /* The CUDA-provided malloc.  */
 void *sys_malloc (size_t) __asm__ ("malloc");
 
-/* The user-visible malloc (renamed by compiler).  */
-void *malloc (size_t size)
+/* malloc, recording FILE and LINE as the call site for heap profiling.  */
+void *
+__nvptx_malloc_at (size_t size, const char *file, int line)
 {
-  long long *ptr = sys_malloc (size + sizeof (long long));
+  if (size > SIZE_MAX - sizeof (struct heap_header))
+    return NULL;
+
+  void *ptr = __nvptx_heap_pool_take (size, 0);
   if (ptr)
-    *(size_t *)ptr++ = size;
+    {
+      __nvptx_heap_note_alloc (ptr, file, line);
+      return ptr;
+    }
 
+  size_t bytes = heap_block_size (size) + sizeof (struct heap_header);
+  void *block = sys_malloc (bytes);
+  if (!block)
+    {
+      /* Blocks kept in the pools may be what's missing.  */
+      __nvptx_heap_drain ();
+      block = sys_malloc (bytes);
+    }
+  if (!block)
+    {
+      __nvptx_heap_note_failure ();
+      return NULL;
+    }
+
+  ptr = heap_user_ptr (block, sizeof (struct heap_header), size);
+  __nvptx_heap_note_alloc (ptr, file, line);
   return ptr;
 }
+
+/* The user-visible malloc (renamed by compiler).  */
+void *malloc (size_t size)
+{
+  return __nvptx_malloc_at (size, NULL, 0);
+}
@@ -14,6 +14,7 @@
  */
 
 #include <stdlib.h>
+#include <malloc.h>
 
 void *_malloc_r (struct _reent *r, size_t n)
 {
@@ -24,3 +25,8 @@ void _free_r (struct _reent *r, void *p)
 {
   free (p);
 }
+
+void *_memalign_r (struct _reent *r, size_t align, size_t n)
+{
+  return memalign (align, n);
+}
@@ -0,0 +1,93 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include "machine/heapprof.h"
+#include "machine/heappool.h"
+#include "heap.h"
+
+/* The CUDA-provided malloc.  */
+void *sys_malloc (size_t) __asm__ ("malloc");
+
+/* memalign, recording FILE and LINE as the call site for heap
+   profiling.  */
+void *
+__nvptx_memalign_at (size_t align, size_t size, const char *file, int line)
+{
+  if (align & (align - 1))
+    {
+      errno = EINVAL;
+      return NULL;
+    }
+  if (align <= HEAP_ALIGN)
+    return __nvptx_malloc_at (size, file, line);
+
+  /* The heap block is HEAP_ALIGN aligned, so moving the user pointer up to
+     ALIGN takes at most ALIGN - HEAP_ALIGN bytes on top of the header.  If
+     the pointer doesn't have to move, free pools the block like one from
+     malloc, so it needs the full size of its class.  */
+  size_t slack = sizeof (struct heap_header) + align - HEAP_ALIGN;
+  size_t bytes = heap_block_size (size);
+  if (bytes > SIZE_MAX - slack)
+    return NULL;
+
+  char *block = sys_malloc (bytes + slack);
+  if (!block)
+    {
+      /* Blocks kept in the pools may be what's missing.  */
+      __nvptx_heap_drain ();
+      block = sys_malloc (bytes + slack);
+    }
+  if (!block)
+    {
+      __nvptx_heap_note_failure ();
+      return NULL;
+    }
+
+  uintptr_t user = ((uintptr_t) block + sizeof (struct heap_header)
+		    + align - 1) & ~(uintptr_t) (align - 1);
+  void *ptr = heap_user_ptr (block, user - (uintptr_t) block, size);
+  __nvptx_heap_note_alloc (ptr, file, line);
+  return ptr;
+}
+
+void *
+memalign (size_t align, size_t size)
+{
+  return __nvptx_memalign_at (align, size, NULL, 0);
+}
+
+void *
+aligned_alloc (size_t align, size_t size)
+{
+  return memalign (align, size);
+}
+
+int
+posix_memalign (void **memptr, size_t align, size_t size)
+{
+  if (align % sizeof (void *) || (align & (align - 1)))
+    return EINVAL;
+
+  void *ptr = memalign (align, size);
+  if (!ptr)
+    return ENOMEM;
+
+  *memptr = ptr;
+  return 0;
+}
@@ -14,24 +14,82 @@
  * they apply.
  */
 
-#define __test__
+// The stdio-only profile replaces all of this by streams.c
+#ifndef VRAMFS_PROFILE_STDIO
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <fcntl.h>
 #include <string.h>
 #include <errno.h>
+#include <stdint.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 
+#include "machine/vramfs.h"
+#include "machine/binlog.h"
+#include "sys/dirent.h"
+#include "warpwrite.h"
+#ifndef VRAMFS_PROFILE_BASIC
+#include "lz.h"
+#endif
+
+// On the host, where the tests build this file, errno is the C library's
+#ifdef __nvptx__
 #undef errno
 extern int errno;
+#endif
+
+// Reads stdin from the ring buffer the host fills, see stdin.c
+extern ssize_t __nvptx_stdin_read(void *buf, size_t count);
+
+// Size of the file system, see the build profiles in Makefile.inc
+#ifndef VRAMFS_MAX_FILES
+#define VRAMFS_MAX_FILES 32
+#endif
+
+#ifndef VRAMFS_MAX_FNAME
+#define VRAMFS_MAX_FNAME 32
+#endif
+
+#ifndef VRAMFS_MAX_FOPEN
+#define VRAMFS_MAX_FOPEN 8
+#endif
+
+// Number of namespace shards, each with its own MAX_FILES / VRAMFS_SHARDS entries
+#ifndef VRAMFS_SHARDS
+#define VRAMFS_SHARDS 1
+#endif
+
+// Number of file descriptor tables, teams beyond this share them round robin
+#ifndef VRAMFS_FD_TABLES
+#define VRAMFS_FD_TABLES 64
+#endif
 
 // Undefine all constants for safety
 #undef MAX_FILES
 #undef MAX_FNAME
 #undef MAX_FOPEN
+#undef DIRTY_BLOCK
+#undef COMPRESS_BLOCK
+#undef COMPRESS_MIN
+#undef DEDUP_BLOCK
+#undef DEDUP_BUCKETS
+#undef MAX_PATH
+#undef NAME_BUCKETS
+#undef DCACHE_SLOTS
+#undef NSHARDS
+#undef SHARD_FILES
+#undef NFD_TABLES
+#undef POOL_BUCKETS
+#undef POOL_DEPTH
+#undef TRUNC_RETAIN
+#undef INLINE_DATA
+#undef STDIO_RECORD
+#undef STDIO_RECORD_SLOTS
+#undef TOMBSTONES
+#undef GROW_MAX
 
 #undef MODE_R
 #undef MODE_W
@@ -45,22 +103,63 @@ extern int errno;
 #undef ERR_ENTRIES_EXHAUSTED
 #undef ERR_NULLPTR
 #undef ERR_NO_SPACE
+#undef ERR_ILLEGAL_SEEK
+#undef ERR_INVALID
+#undef ERR_NOT_DIR
+#undef ERR_IS_DIR
+#undef ERR_NAME_TOO_LONG
+#undef ERR_EXISTS
+#undef ERR_NOT_EMPTY
+#undef ERR_BUSY
+#undef ERR_WOULD_BLOCK
+
+#undef ENT_TYPE_FREE
+#undef ENT_TYPE_REGULAR
+#undef ENT_TYPE_DEVICE
+#undef ENT_TYPE_STREAM
+#undef ENT_TYPE_DIRECTORY
 
 #undef UNRESERVED_FD_START
 
+#undef ENT_DEVDIR
+#undef NDEV_ENTRIES
 #undef ENT_DEVNULL
+#undef ENT_DEVZERO
+#undef ENT_DEVURANDOM
+#undef ENT_STDIN
+#undef ENT_STDOUT
+#undef ENT_STDERR
 
-#undef STDIN
-#undef STDOUT
-#undef STDERR
 
 
 enum FileSystemLimits {
-  MAX_FILES = 32,       // Maximum number of files supported
-  MAX_FNAME = 32,		    // Maximum supported length of filename
-  MAX_FOPEN = 8 		    // Maximum number of simultaneously open files
+  MAX_FILES = VRAMFS_MAX_FILES,  // Maximum number of files supported
+  MAX_FNAME = VRAMFS_MAX_FNAME,  // Maximum supported length of a file name component
+  MAX_FOPEN = VRAMFS_MAX_FOPEN,  // Maximum number of simultaneously open files
+  DIRTY_BLOCK = 4096,   // Granularity of dirty tracking for incremental host sync
+  COMPRESS_BLOCK = 16384, // Files are compressed in independent blocks of this size
+  COMPRESS_MIN = 4096,  // Smallest file worth compressing under memory pressure
+  DEDUP_BLOCK = 4096,   // Files are deduplicated in blocks of this size
+  DEDUP_BUCKETS = 1024, // Hash chains of the deduplicated block store
+  MAX_PATH = 256,       // Longest directory path kept in the dentry cache
+  NAME_BUCKETS = 64,    // Hash chains of the name index
+  DCACHE_SLOTS = 8,     // Recently resolved directories remembered by path
+  NSHARDS = VRAMFS_SHARDS,  // Independently locked partitions of the namespace
+  SHARD_FILES = MAX_FILES / VRAMFS_SHARDS,  // Entries of each shard
+  NFD_TABLES = VRAMFS_FD_TABLES,  // Per-team file descriptor tables
+  POOL_BUCKETS = 16,    // Size classes of the data buffer pool, doubling from 128 bytes
+  POOL_DEPTH = 4,       // Data buffers kept for reuse in each size class
+  TRUNC_RETAIN = 1 << 20,  // Largest data buffer a file keeps when it's truncated on open
+  INLINE_DATA = 48,     // Files up to this size keep their data inside their Entry
+  STDIO_RECORD = 1024,  // Bytes of a file that sendfile() emits per printf record
+  STDIO_RECORD_SLOTS = 8,  // Buffers those records are assembled in, rather than on the stack
+  TOMBSTONES = 64,      // Removed paths remembered for the host's deltas
+  GROW_MAX = 1 << 20    // Most a data buffer grows by beyond the size it's needed for
 };
 
+_Static_assert(MAX_FILES % NSHARDS == 0, "MAX_FILES must be a multiple of VRAMFS_SHARDS");
+_Static_assert(MAX_FNAME <= MAXNAMLEN + 1, "MAX_FNAME must fit struct dirent");
+
 
 enum SupportedFileOpenModes {
   MODE_R = O_RDONLY,
@@ -77,81 +176,377 @@ enum FileIOErrors {
   ERR_ENTRY_NOT_FOUND = -2,
   ERR_ENTRIES_EXHAUSTED = -3,
   ERR_NULLPTR = -4,
-  ERR_NO_SPACE = -5
-}; 
+  ERR_NO_SPACE = -5,
+  ERR_ILLEGAL_SEEK = -6,
+  ERR_INVALID = -7,
+  ERR_NOT_DIR = -8,
+  ERR_IS_DIR = -9,
+  ERR_NAME_TOO_LONG = -10,
+  ERR_EXISTS = -11,
+  ERR_NOT_EMPTY = -12,
+  ERR_BUSY = -13,
+  ERR_WOULD_BLOCK = -14
+};
+
+
+// The kind of object a file system entry represents
+enum EntryTypes {
+  ENT_TYPE_FREE = 0,        // Empty slot in vramfs
+  ENT_TYPE_REGULAR,         // Regular file, contents live in Entry.data
+  ENT_TYPE_DEVICE,          // Built-in character device (/dev/null, /dev/zero, ...)
+  ENT_TYPE_STREAM,          // Standard I/O stream (stdin, stdout, stderr)
+  ENT_TYPE_DIRECTORY        // Directory, its children are linked from Entry.children
+};
+
+
+struct File;
+struct Entry;
+struct CompressedData;
+struct DedupBlock;
+
+/* Operations table of a file system entry. The system calls dispatch through
+ * this with a single indirect call, so no name or fd based special casing is
+ * needed on the read/write paths. All operations return 0 or an ERR_* code.
+ */
+struct EntryOps {
+  int (*read) (struct File *file, void *buf, size_t count, ssize_t *new_count_ref);
+  int (*write) (struct File *file, const void *buf, size_t count, ssize_t *new_count_ref);
+  int (*seek) (struct File *file, off_t offset, int whence, off_t *new_offset_ref);
+  int (*stat) (struct Entry *entref, struct stat *buf);
+};
 
 
 // This is the actual file system entry data structure with its metadata
 struct Entry {
-  char name[MAX_FNAME];    // Null-terminated string to store file name
-  size_t size;             // Store file size in bytes
-  char *data;              // Actual file data (dynamically allocated)
+  char name[MAX_FNAME];         // Null-terminated name of the entry within its directory
+  size_t size;                  // Store file size in bytes
+  char *data;                   // Actual file data (dynamically allocated)
+  int type;                     // One of EntryTypes
+  const struct EntryOps *ops;   // Operations for this entry (NULL for free slots)
+  size_t capacity;              // Allocated size of data (>= size)
+  char inline_data[INLINE_DATA] __attribute__((aligned(16)));  // Data of a small file, data points here then
+  unsigned int epoch;           // fs_epoch the entry was created in (regular files only)
+  unsigned long long gen;       // Generation of the last modification
+  unsigned long long name_gen;  // Generation the entry got its current name in
+  unsigned long long *block_gen;  // Generation of the last write to each DIRTY_BLOCK
+  size_t nblocks;               // Number of elements in block_gen
+  struct CompressedData *zdata; // Compressed data, replaces data when not NULL
+  char *zcache;                 // The most recently decompressed block of zdata
+  size_t zcache_block;          // Index of the block in zcache
+  struct DedupBlock **dblocks;  // Shared blocks, replace data when not NULL
+  struct Entry *parent;         // Directory containing the entry, NULL if not linked into one
+  struct Entry *children;       // First entry of a directory
+  struct Entry *prev_sibling;   // Neighbours within the parent's list of children
+  struct Entry *next_sibling;
+  struct Entry *hash_next;      // Next entry in the name index chain, or in the free list
+  unsigned int name_hash;       // Hash of parent and name, selects the shard and the chain
+  unsigned int incarnation;     // Advanced whenever a directory starts a new list of children
+  unsigned int parent_incarnation;  // parent->incarnation when the entry was linked into it
+  int lock;                     // Guards the list of children of a directory
+  unsigned int nopen;           // Number of file descriptors open on the entry
+  unsigned int nlink;           // Number of names of a regular file
+  struct Entry *inode;          // For a hard link, the entry holding the file, otherwise NULL
 };
 
 
-// Pre-define an entry for /dev/null.
-#define ENT_DEVNULL {    \
-  .name = "/dev/null",   \
-  .size = 0,             \
-  .data = NULL           \
-}
+/* Compressed form of a file's data. Every COMPRESS_BLOCK sized block is compressed on
+ * its own and in its own allocation, so that a read only needs to decompress the blocks
+ * it touches. A block that doesn't compress is stored as is, which shows as a size
+ * equal to the block's uncompressed size.
+ */
+struct CompressedData {
+  size_t nblocks;
+  struct {
+    char *data;
+    size_t size;
+  } blocks[];
+};
+
+
+/* A block of file data in the content-addressed block store, shared by reference count
+ * between all deduplicated files that contain it.
+ */
+struct DedupBlock {
+  struct DedupBlock *next;      // Next block in the hash chain
+  unsigned long long hash;
+  unsigned int refs;
+  unsigned int size;            // DEDUP_BLOCK, except for the last block of a file
+  char data[];
+};
 
 
 // This is the data structure that stores metadata about a file
 struct File {
-  size_t offset;	          // Current read/write offset within the file (0 <= offset <= size)
+  size_t offset;	          // Current read/write offset within the file
   int mode;		              // The mode in which the file was opened
   struct Entry *entref;     // Reference to a file system entry
+  unsigned int epoch;       // fs_epoch the file was opened in
+};
+
+
+static int read_entry_data(struct File *file, void *buf, size_t count, ssize_t *new_count_ref);
+static int write_entry_data(struct File *file, const void *buf, size_t count, ssize_t *new_count_ref);
+static int seek_entry(struct File *file, off_t offset, int whence, off_t *new_offset_ref);
+static int stat_entry(struct Entry *entref, struct stat *buf);
+
+static int read_devzero(struct File *file, void *buf, size_t count, ssize_t *new_count_ref);
+static int read_devurandom(struct File *file, void *buf, size_t count, ssize_t *new_count_ref);
+static int read_eof(struct File *file, void *buf, size_t count, ssize_t *new_count_ref);
+static int read_stdin(struct File *file, void *buf, size_t count, ssize_t *new_count_ref);
+static int write_discard(struct File *file, const void *buf, size_t count, ssize_t *new_count_ref);
+static int write_stdio(struct File *file, const void *buf, size_t count, ssize_t *new_count_ref);
+static int write_capture(struct File *file, const void *buf, size_t count, ssize_t *new_count_ref);
+static int seek_device(struct File *file, off_t offset, int whence, off_t *new_offset_ref);
+static int seek_stream(struct File *file, off_t offset, int whence, off_t *new_offset_ref);
+static int stat_chardev(struct Entry *entref, struct stat *buf);
+
+static int read_dir(struct File *file, void *buf, size_t count, ssize_t *new_count_ref);
+static int write_dir(struct File *file, const void *buf, size_t count, ssize_t *new_count_ref);
+static int stat_dir(struct Entry *entref, struct stat *buf);
+
+static const struct EntryOps regular_ops = {
+  .read = read_entry_data,
+  .write = write_entry_data,
+  .seek = seek_entry,
+  .stat = stat_entry
+};
+
+static const struct EntryOps devnull_ops = {
+  .read = read_eof,
+  .write = write_discard,
+  .seek = seek_device,
+  .stat = stat_chardev
 };
 
+static const struct EntryOps devzero_ops = {
+  .read = read_devzero,
+  .write = write_discard,
+  .seek = seek_device,
+  .stat = stat_chardev
+};
+
+static const struct EntryOps devurandom_ops = {
+  .read = read_devurandom,
+  .write = write_discard,
+  .seek = seek_device,
+  .stat = stat_chardev
+};
 
-/* We don't need any buffering at all: reading from stdin just always returns
- * something like "no data", and write-ing to stdout, stderr just invokes printf.
- * Hence, entref for STDIN, STDOUT, STDERR as defined below are NULL.
+/* We don't need any buffering at all: reading from stdin takes what the host put
+ * into __vramfs_stdin (or returns end of file), writing to it is a no-op, and
+ * write-ing to stdout, stderr just invokes printf.
  */
-#define STDIN {                 \
-  .offset = 0,                  \
-  .mode = MODE_RW_TRUNC,        \
-  .entref = NULL                \
-}               
-#define STDOUT {                \
-  .offset = 0,                  \
-  .mode = MODE_RW_TRUNC,        \
-  .entref = NULL                \
-}               
-#define STDERR {                \
-  .offset = 0,                  \
-  .mode = MODE_RW_TRUNC,        \
-  .entref = NULL                \
-}
+static const struct EntryOps stdin_ops = {
+  .read = read_stdin,
+  .write = write_discard,
+  .seek = seek_stream,
+  .stat = stat_chardev
+};
+
+static const struct EntryOps stdout_ops = {
+  .read = read_eof,
+  .write = write_stdio,
+  .seek = seek_stream,
+  .stat = stat_chardev
+};
+
+/* Captured stdout and stderr are ordinary readable files, except that their data lives
+ * in __vramfs_capture instead of the device heap, so the host can copy it out in one go.
+ */
+static const struct EntryOps capture_ops = {
+  .read = read_entry_data,
+  .write = write_capture,
+  .seek = seek_entry,
+  .stat = stat_entry
+};
+
+/* Directories can't be opened as files, but their entries go through the same
+ * dispatch as everything else, e.g. for stat.
+ */
+static const struct EntryOps dir_ops = {
+  .read = read_dir,
+  .write = write_dir,
+  .seek = seek_device,
+  .stat = stat_dir
+};
+
+
+/* The root directory is not part of vramfs, so it doesn't take up any of the
+ * MAX_FILES slots, and it can't be removed. Neither do /dev and the devices in
+ * dev_entries: /dev, /dev/null, /dev/zero and /dev/urandom. Like all tables of the
+ * file system, these are zero-initialized so that they take up no space in the
+ * module image, and init_namespace() fills them in on first use.
+ */
+static struct Entry root_dir;
+
+#define NDEV_ENTRIES 4
+static struct Entry dev_entries[NDEV_ENTRIES];
+
+
+
+
+/* This is a VRAM buffer simulating a formatted disk to store all the entries. All of
+ * them start out free, which is all zeros (ENT_TYPE_FREE is 0).
+ * Shard i owns the SHARD_FILES entries starting at vramfs[i * SHARD_FILES].
+ */
+static struct Entry vramfs[MAX_FILES];
+
+
+/* The standard I/O streams are not part of the vramfs namespace, so they don't
+ * take up any of the MAX_FILES slots. init_namespace() fills them in.
+ */
+static struct Entry stdio_entries[3];
+
+
+// Names of the vramfs entries backing fd 1 & 2 while they are captured
+static const char *const capture_names[2] = {
+  "/dev/stdout.capture",
+  "/dev/stderr.capture"
+};
 
+// Serializes binding fd 1 & 2 to the capture entries and back
+static int capture_lock;
 
-/* This is a VRAM buffer simulating a formatted disk to store all the entries
- * WARNING: This initialization is not standard C, but GCC supported
+
+/* Backing store for captured stdout and stderr. This is deliberately left uninitialized,
+ * so that it doesn't take up space in the module image; see machine/vramfs.h.
+ */
+struct __vramfs_capture __vramfs_capture;
+
+
+
+
+/* File system generation counter, advanced by every modification of a regular file.
+ * Deltas for the host are computed relative to a generation.
+ */
+static unsigned long long fs_generation;
+
+
+/* File system epoch, advanced by __vramfs_reset(). Regular files and file descriptors
+ * (other than the standard streams) from an older epoch are stale: they are treated as
+ * free slots, and reclaimed when a slot is needed. A stale entry's data buffer is kept
+ * and reused by the next file created in its slot.
+ */
+static unsigned int fs_epoch;
+
+
+/* Generation taken by the last __vramfs_reset(). A delta since an older generation
+ * can't describe the files the reset discarded, so it resends everything instead.
+ */
+static unsigned long long reset_generation;
+
+
+/* Paths removed by unlink(), rmdir() and rename(), along with the generation they were
+ * removed in, so that deltas can tell the host to remove them too. A path removed again replaces its
+ * own tombstone; otherwise the oldest is forgotten, and a delta since before the
+ * generation of a forgotten one is a full resync.
+ */
+static struct {
+  int lock;
+  unsigned long long floor;     // Generation of the newest forgotten removal
+  struct {
+    unsigned long long gen;     // 0 for unused slots
+    size_t len;
+    char path[MAX_PATH];
+  } slots[TOMBSTONES];
+} removals;
+
+
+// Compression settings and instrumentation, see machine/vramfs.h
+size_t __vramfs_compress_threshold;
+struct __vramfs_compress_stats __vramfs_compress_stats;
+
+
+// Deduplication settings, instrumentation and the block store, see machine/vramfs.h
+int __vramfs_dedup_enabled;
+struct __vramfs_dedup_stats __vramfs_dedup_stats;
+static struct {
+  int lock;                     // Guards the chain and the reference counts of its blocks
+  struct DedupBlock *blocks;
+} dedup_buckets[DEDUP_BUCKETS];
+
+
+/* The namespace is split into NSHARDS shards by the hash of an entry's parent and
+ * name. A shard owns a range of vramfs slots, keeps its free slots in a list, and
+ * holds the name index for its entries: every entry linked into a directory is on
+ * the chain selected by its hash, so looking up a path component is a walk of one
+ * short chain rather than a scan of all entries. The shard's lock guards all of
+ * this, so creating entries in different shards doesn't contend. An entry starts
+ * out in the shard its name hashes to; rename() moves only its name to the chain
+ * of another shard, so an entry's slot and its chain may be in different shards.
+ * The lists of children span shards, and are guarded by the lock of their directory
+ * instead. Locks are always taken in the order shard (two of them by index),
+ * directory, parent directory.
  */
-static struct Entry vramfs[MAX_FILES] = {
-  ENT_DEVNULL,
-  [1 ... MAX_FILES - 1] = {
-  .name = "",
-  .size = 0,
-  .data = NULL
-}};
+struct Shard {
+  int lock;
+  struct Entry *free_list;
+  struct Entry *buckets[NAME_BUCKETS];
+};
+
+static struct Shard shards[NSHARDS];
+static int namespace_state;     // 0 before init_namespace(), 1 during, 2 after
+
+
+// Data buffers given up by files, handed on to files that need one, see pool_buffer()
+static struct {
+  int lock;
+  struct {
+    char *data;
+    size_t capacity;
+  } slots[POOL_DEPTH];
+} buffer_pool[POOL_BUCKETS];
+
+
+/* The dentry cache maps the text of recently resolved directory paths to their
+ * entries, so that repeated opens under the same directory resolve it with one
+ * compare. Any change that can make a cached path resolve differently (removing or
+ * reusing a directory) flushes the whole cache by advancing dentry_cache_gen, and
+ * entries from an older epoch are ignored. A slot that another thread is using
+ * is simply skipped.
+ */
+struct DentryCacheSlot {
+  int lock;
+  unsigned int gen;
+  struct Entry *dir;
+  unsigned int epoch;
+  unsigned int len;
+  char path[MAX_PATH];
+};
+
+static struct DentryCacheSlot dentry_cache[DCACHE_SLOTS];
+static unsigned int dentry_cache_next;
+static unsigned int dentry_cache_gen;
+
+// Buffers for the records of emit_stdio_records(), too large for the GPU stack
+static struct {
+  int lock;
+  char data[STDIO_RECORD + 1];
+} stdio_records[STDIO_RECORD_SLOTS];
+static unsigned int stdio_records_next;
 
 
 // File descriptors 0, 1 & 2 would be reserved for STDIN, STDOUT & STDERR respectively
 #define UNRESERVED_FD_START 3
 
 
-// The file table for all open files. STDIN, STDOUT, STDERR are open by default.
-static struct File open_files[MAX_FOPEN] = {
-  STDIN,      // fd = 0
-  STDOUT,     // fd = 1
-  STDERR,     // fd = 2
-  [UNRESERVED_FD_START ... MAX_FOPEN - 1] = {
-  .offset = 0,
-  .mode = -1,
-  .entref = NULL
-}};
+// STDIN, STDOUT, STDERR are open from init_namespace() on, and shared by all teams
+static struct File stdio_files[UNRESERVED_FD_START];
+
+
+/* Every team (thread block) gets a table for the remaining file descriptors, so that
+ * opening and looking up files never touches another team's cache lines. A slot is
+ * free when its entref is NULL, or when it is left over from an older epoch. The
+ * lock serializes open() within the team. With __vramfs_shared_fds set, all teams
+ * use the first table instead.
+ */
+struct FdTable {
+  int lock;
+  struct File files[MAX_FOPEN - UNRESERVED_FD_START];
+} __attribute__((aligned(128)));
+
+static struct FdTable fd_tables[NFD_TABLES];
+int __vramfs_shared_fds;
 
 
 /**************************************** INTERNAL SUBROUTINES ****************************************/
@@ -162,429 +557,3188 @@ static struct File open_files[MAX_FOPEN] = {
  * are dealing with raw bytes in such case. We track the file size externally using the size value of File. 
 */
 
-#ifdef __test__
-static void __test() {
-  printf ("sizeof(_READ_WRITE_RETURN_TYPE) = %d bytes\n", sizeof(_READ_WRITE_RETURN_TYPE));
-  printf ("sizeof(_ssize_t) = %d bytes\n", sizeof(_ssize_t));
-  printf ("sizeof(ssize_t) = %d bytes\n", sizeof(ssize_t));
+static int find_entry(const char *name, struct Entry **entref_ptr);
+static int init_entry(const char *name, struct Entry **entref_ptr);
+static void init_namespace(void);
+static void spin_lock(int *lock);
+static int spin_trylock(int *lock);
+static void spin_unlock(int *lock);
+static struct Shard *slot_shard(const struct Entry *entref);
+static void record_removal(const struct Entry *entref);
 
-  const char *data = "Hello world!";
-  strncpy(vramfs[UNRESERVED_FD_START].name, "hello_test.txt", MAX_FNAME);
-  vramfs[UNRESERVED_FD_START].size = strlen(data);
-  vramfs[UNRESERVED_FD_START].data = malloc(vramfs[UNRESERVED_FD_START].size + 1);
-  if (vramfs[UNRESERVED_FD_START].data)
-    memcpy(vramfs[UNRESERVED_FD_START].data, data, vramfs[UNRESERVED_FD_START].size);
+
+static int entry_is_live(const struct Entry *entref) {
+/* Devices and streams are always live, regular files and directories only in the epoch
+ * they were created in (or carried over into by __vramfs_reset()).
+ */
+  if (entref->type == ENT_TYPE_REGULAR || entref->type == ENT_TYPE_DIRECTORY)
+    return entref->epoch == fs_epoch;
+  return entref->type != ENT_TYPE_FREE;
 }
+
+static struct FdTable *fd_table(void) {
+/* The calling team's file descriptor table. */
+  if (__vramfs_shared_fds)
+    return fd_tables;
+
+#ifdef __nvptx__
+  unsigned int ctaid_x, ctaid_y, ctaid_z, nctaid_x, nctaid_y;
+  asm ("mov.u32 %0, %%ctaid.x;" : "=r" (ctaid_x));
+  asm ("mov.u32 %0, %%ctaid.y;" : "=r" (ctaid_y));
+  asm ("mov.u32 %0, %%ctaid.z;" : "=r" (ctaid_z));
+  asm ("mov.u32 %0, %%nctaid.x;" : "=r" (nctaid_x));
+  asm ("mov.u32 %0, %%nctaid.y;" : "=r" (nctaid_y));
+  return fd_tables + ((ctaid_z * nctaid_y + ctaid_y) * nctaid_x + ctaid_x) % NFD_TABLES;
+#else
+  // On the host, every thread is a team of its own
+  static unsigned int nteams;
+  static __thread int team = -1;
+  if (team < 0)
+    team = __atomic_fetch_add(&nteams, 1, __ATOMIC_RELAXED) % NFD_TABLES;
+  return fd_tables + team;
 #endif
+}
 
-static int find_entry(const char *name, struct Entry **entref_ptr) {
-/* Searches for the entry with the given name in the file system.
- * TODO: Optimize searching algorithm
+static struct File *fd_file(int fd) {
+/* Returns the open file of fd, or NULL. An fd is open if it is in range, its slot is
+ * in use, and it wasn't opened before the last __vramfs_reset(). The standard streams
+ * are never reset.
  */
-  if (!name || !entref_ptr)
-    return ERR_NULLPTR;
-
-  for (int i = 0; i < MAX_FILES; ++i) {
-    if (!strcmp(vramfs[i].name, name)) {
-      *entref_ptr = vramfs + i;
-      return 0;
-    }
+  if (fd < 0 || fd > MAX_FOPEN - 1)
+    return NULL;
+  if (fd < UNRESERVED_FD_START) {
+    init_namespace();
+    return stdio_files + fd;
   }
-  return ERR_ENTRY_NOT_FOUND;
+
+  struct File *file = fd_table()->files + fd - UNRESERVED_FD_START;
+  if (!__atomic_load_n(&file->entref, __ATOMIC_ACQUIRE) || file->epoch != fs_epoch)
+    return NULL;
+  return file;
 }
 
-static int init_entry(const char *name, struct Entry **entref_ptr) {
-/* Initializes an empty entry in the file system with the given name.
- * It is assumed that an entry with the given name doesn't exist in
- * the file system. Caller should verify this by running find_entry().
- * TODO: Optimize searching algorithm
+static unsigned long long read_clock64(void) {
+/* The cycle counter for the statistics, which the host doesn't have. */
+#ifdef __nvptx__
+  unsigned long long clock;
+  asm volatile ("mov.u64 %0, %%clock64;" : "=r" (clock));
+  return clock;
+#else
+  return 0;
+#endif
+}
+
+static int data_is_inline(const struct Entry *entref) {
+  return entref->data == entref->inline_data;
+}
+
+static int pool_bucket(size_t size) {
+/* Returns the size class of a buffer of size bytes: class 0 holds buffers of less than
+ * 128 bytes, and every class after it buffers of up to twice the size of the one before.
  */
-  if (!name || !entref_ptr)
-    return ERR_NULLPTR;
+  int bucket = 0;
+  while (bucket < POOL_BUCKETS - 1 && size >= ((size_t)128 << bucket))
+    ++bucket;
+  return bucket;
+}
 
-  for (int i = 0; i < MAX_FILES; ++i) {
-    if (!strcmp(vramfs[i].name, "")) {
-      strncpy(vramfs[i].name, name, MAX_FNAME);
-      *entref_ptr = vramfs + i;
-      return 0;
-    }
+static void pool_buffer(char *data, size_t capacity) {
+/* Keeps a data buffer that a file gave up for another one, in place of the smallest
+ * buffer of its size class if the class is full and that is smaller. Whatever doesn't
+ * stay is freed.
+ */
+  if (!data)
+    return;
+
+  int bucket = pool_bucket(capacity);
+  spin_lock(&buffer_pool[bucket].lock);
+  int slot = 0;
+  for (int i = 1; i < POOL_DEPTH; ++i) {
+    if (buffer_pool[bucket].slots[i].capacity < buffer_pool[bucket].slots[slot].capacity)
+      slot = i;
   }
-  return ERR_ENTRIES_EXHAUSTED;
+  if (buffer_pool[bucket].slots[slot].capacity < capacity) {
+    char *evicted = buffer_pool[bucket].slots[slot].data;
+    buffer_pool[bucket].slots[slot].data = data;
+    buffer_pool[bucket].slots[slot].capacity = capacity;
+    data = evicted;
+  }
+  spin_unlock(&buffer_pool[bucket].lock);
+  free(data);
 }
 
-static int clear_entry(struct Entry *entref) {
- /* Clears the data & metadata of the file system entry without removing it.
-  * The name is left intact.
-  */
-  if (!entref)
-    return ERR_NULLPTR;
-
-  entref->size = 0;
-  free(entref->data);
+static void pool_entry_data(struct Entry *entref) {
+/* Hands the data buffer of a file over to the pool, unless it's the inline one. */
+  if (!data_is_inline(entref))
+    pool_buffer(entref->data, entref->capacity);
   entref->data = NULL;
-  return 0;
+  entref->capacity = 0;
 }
 
-static int read_entry_data(struct File *file, void *buf, size_t count, ssize_t *new_count_ref) {
-/* Read the data from the file system entry that file's entref points to. Reading is started
- * from file's offset. Read data is copied into buf. On success, 0 is returned.
- */
-  if ((!file) || (!file->entref) || (!buf))
-    return ERR_NULLPTR;
+#ifndef VRAMFS_PROFILE_BASIC
+static void add_stat(unsigned long long *stat, unsigned long long n) {
+/* Statistics are updated by every team at once. */
+  __atomic_add_fetch(stat, n, __ATOMIC_RELAXED);
+}
 
-  // If the data is NULL, don't modify buf & set *new_count_ref to 0 because there's no data (no error)
-  if (!(file->entref)->data) {
-    *new_count_ref = 0;
-    return 0;
-  }
-  memcpy(buf, (file->entref)->data + file->offset, count);
-  *new_count_ref = count;
-  return 0;
+static void sub_stat(unsigned long long *stat, unsigned long long n) {
+  __atomic_sub_fetch(stat, n, __ATOMIC_RELAXED);
 }
 
-static int write_entry_data(struct File *file, const void *buf, size_t count, ssize_t *new_count_ref) {
- /* Write the contents of buf to data of the file system entry that file's entref points to.
-  * Writing is started from the file's offset. On success, 0 is returned.
-  * *file should be a valid element of the open_files file table, otherwise KA-BOOM!!!
-  */
+static int entry_is_closed(const struct Entry *entref) {
+/* A live regular file that isn't open. Only stable while the lock of the shard owning
+ * its slot is held, as open() pins files under that lock.
+ */
+  return entref->type == ENT_TYPE_REGULAR && entry_is_live(entref) && !__atomic_load_n(&entref->nopen, __ATOMIC_ACQUIRE);
+}
 
-  if ((!file) || (!file->entref) || (!buf))
-    return ERR_NULLPTR;
+static size_t zblock_size(const struct Entry *entref, size_t block) {
+/* Uncompressed size of the given block of the entry. */
+  size_t start = block * COMPRESS_BLOCK;
+  return entref->size - start < COMPRESS_BLOCK ? entref->size - start : COMPRESS_BLOCK;
+}
 
-  // If file is an element of open_files (which it should be), below should give the fd.
-  int fd = (int)(file - open_files);
+static void drop_compressed(struct Entry *entref) {
+/* Frees the compressed data of the entry, if any. */
+  if (entref->zdata) {
+    for (size_t i = 0; i < entref->zdata->nblocks; ++i)
+      free(entref->zdata->blocks[i].data);
+    free(entref->zdata);
+    entref->zdata = NULL;
+  }
+  free(entref->zcache);
+  entref->zcache = NULL;
+}
 
-  char *cbuf = (char *)buf;
+static int compress_entry(struct Entry *entref) {
+/* Replaces the data of the entry by its compressed form. The data is left alone unless
+ * compression saves at least an eighth of it. Returns 0 if the entry was compressed.
+ */
+  if (entref->zdata || !entref->data || !entref->size || data_is_inline(entref))
+    return ERR_INVALID;
+
+  unsigned long long start = read_clock64();
+  size_t nblocks = (entref->size + COMPRESS_BLOCK - 1) / COMPRESS_BLOCK;
+  struct CompressedData *zdata = malloc(sizeof(struct CompressedData) + nblocks * sizeof(zdata->blocks[0]));
+  unsigned short *table = malloc(LZ_WORK_ELEMS * sizeof(unsigned short));
+  char *scratch = malloc(COMPRESS_BLOCK);
+  int errcode = ERR_NO_SPACE;
+
+  if (!zdata || !table || !scratch) {
+    free(zdata);
+    zdata = NULL;
+    goto out;
+  }
 
-  // Handle the standard I/O files first
-  switch (fd) {
+  size_t packed = 0;
+  zdata->nblocks = 0;
+  for (size_t i = 0; i < nblocks; ++i) {
+    size_t raw = zblock_size(entref, i);
+    const char *src = entref->data + i * COMPRESS_BLOCK;
+    size_t n = __nvptx_lz_compress(src, raw, scratch, raw - 1, table);
+    if (!n)  // Doesn't compress, store it as is
+      n = raw;
+
+    char *block = malloc(n);
+    if (!block)
+      goto out;
+    memcpy(block, n == raw ? src : scratch, n);
+    zdata->blocks[i].data = block;
+    zdata->blocks[i].size = n;
+    zdata->nblocks = i + 1;
+    packed += n;
+  }
 
-    // STDIN (currently, it's not clear what writing to STDIN actually does, so below is a stub)
-    case 0:
-    *new_count_ref = count;
-    return 0;
+  errcode = ERR_INVALID;
+  if (packed > entref->size - entref->size / 8)
+    goto out;
 
-    // STDOUT (writing to STDOUT invokes printf)
-    case 1:
-    for (size_t i = 0; i < count; ++i)
-      *new_count_ref += printf ("%c", cbuf[i]);
-    return 0;
+  add_stat(&__vramfs_compress_stats.files, 1);
+  add_stat(&__vramfs_compress_stats.bytes_in, entref->size);
+  add_stat(&__vramfs_compress_stats.bytes_out, packed);
 
-    // STDERR (writing to STDERR invokes printf)
-    case 2:
-    for (size_t i = 0; i < count; ++i)
-      *new_count_ref += printf ("%c", cbuf[i]);
-    return 0;
+  pool_entry_data(entref);
+  entref->zdata = zdata;
+  zdata = NULL;
+  errcode = 0;
+
+out:
+  if (zdata) {
+    for (size_t i = 0; i < zdata->nblocks; ++i)
+      free(zdata->blocks[i].data);
+    free(zdata);
   }
+  free(table);
+  free(scratch);
+  add_stat(&__vramfs_compress_stats.compress_cycles, read_clock64() - start);
+  return errcode;
+}
 
-  // For /dev/null
-  if (!strcmp((file->entref)->name, "/dev/null")) {
-    *new_count_ref = count;
-    return 0;
-  } 
+static int inflate_block(const struct Entry *entref, size_t block, char *buf) {
+/* Decompresses the given block of the entry into buf. */
+  size_t raw = zblock_size(entref, block);
+  const char *src = entref->zdata->blocks[block].data;
+  size_t n = entref->zdata->blocks[block].size;
 
-  // For generic files
-  size_t cur_size, new_size;
-  cur_size = (file->entref)->size;
-  new_size = cur_size + count;
-    
-  char *new_data = NULL;
-  if (new_size > cur_size)
-    new_data = realloc((file->entref)->data, new_size);
-
-  if (!new_data)  // Probably out of memory
+  if (n == raw)
+    memcpy(buf, src, raw);
+  else if (__nvptx_lz_decompress(src, n, buf, raw) != raw)
+    return ERR_INVALID;
+  return 0;
+}
+
+static int inflate_entry(struct Entry *entref) {
+/* Turns a compressed entry back into a plain one, before it gets modified. */
+  unsigned long long start = read_clock64();
+  char *data = malloc(entref->size);
+  if (!data)
     return ERR_NO_SPACE;
 
-  (file->entref)->data = new_data;
-  memcpy((file->entref)->data + file->offset, buf, count);
-  (file->entref)->size = new_size;
-  *new_count_ref = count;
+  for (size_t i = 0; i < entref->zdata->nblocks; ++i) {
+    if (inflate_block(entref, i, data + i * COMPRESS_BLOCK)) {
+      free(data);
+      return ERR_INVALID;
+    }
+  }
 
+  drop_compressed(entref);
+  entref->data = data;
+  entref->capacity = entref->size;
+  add_stat(&__vramfs_compress_stats.files_inflated, 1);
+  add_stat(&__vramfs_compress_stats.decompress_cycles, read_clock64() - start);
   return 0;
 }
-/*****************************************************************************************************/
 
+static int compress_closed_entry(struct Entry *entref) {
+/* Compresses a regular file that isn't open. The caller holds the lock of the shard
+ * owning its slot, which keeps open() from pinning the file in the meantime.
+ */
+  return entry_is_closed(entref) ? compress_entry(entref) : ERR_BUSY;
+}
 
-/******************************************* SYSTEM CALLS *******************************************/
-int
-close(int fd) {
+static int compress_cold_entries(const struct Entry *except) {
+/* Compresses the closed regular files, to make room on the device heap. Returns the
+ * number of files that were compressed. The caller may hold a shard lock, so shards
+ * that are busy are passed over rather than waited for.
+ */
+  int ncompressed = 0;
 
-  // No illegal file descriptors allowed
-  if (fd < 0 || fd > MAX_FOPEN - 1) {
-    errno = EBADF;
-    return -1;
+  for (int i = 0; i < NSHARDS; ++i) {
+    if (!spin_trylock(&shards[i].lock))
+      continue;
+
+    struct Entry *slots = vramfs + i * SHARD_FILES;
+    for (int j = 0; j < SHARD_FILES; ++j) {
+      struct Entry *entref = slots + j;
+      if (entref != except && !entref->zdata && entref->size >= COMPRESS_MIN && !compress_closed_entry(entref))
+        ++ncompressed;
+    }
+    spin_unlock(&shards[i].lock);
   }
+  return ncompressed;
+}
 
-  // fd is a valid but not open file descriptor
-  if (open_files[fd].mode == -1) {
-    errno = EBADF;
-    return -1;
+static unsigned long long hash_block(const char *data, size_t len) {
+/* Fast non-cryptographic hash, 8 bytes at a time. Blocks with equal hashes are still
+ * compared byte by byte before they are shared.
+ */
+  unsigned long long h = len * 0x9e3779b97f4a7c15ull;
+  unsigned long long word;
+  size_t i;
+
+  for (i = 0; i + sizeof(word) <= len; i += sizeof(word)) {
+    memcpy(&word, data + i, sizeof(word));
+    h = (h ^ word) * 0xff51afd7ed558ccdull;
+    h ^= h >> 32;
+  }
+  if (i < len) {
+    word = 0;
+    memcpy(&word, data + i, len - i);
+    h = (h ^ word) * 0xff51afd7ed558ccdull;
   }
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  return h ^ (h >> 33);
+}
 
-  // Offset should be reset for all open files
-  open_files[fd].offset = 0;
+static void release_dedup_block(struct DedupBlock *block) {
+/* Drops a reference to a shared block, freeing it with the last one. */
+  int *lock = &dedup_buckets[block->hash % DEDUP_BUCKETS].lock;
+  sub_stat(&__vramfs_dedup_stats.logical_bytes, block->size);
+  spin_lock(lock);
+  if (--block->refs) {
+    spin_unlock(lock);
+    return;
+  }
 
-  // For all default open files which won't actually be closed
-  if (fd < UNRESERVED_FD_START)
-    return 0;
+  struct DedupBlock **link = &dedup_buckets[block->hash % DEDUP_BUCKETS].blocks;
+  while (*link != block)
+    link = &(*link)->next;
+  *link = block->next;
+  spin_unlock(lock);
+  sub_stat(&__vramfs_dedup_stats.stored_bytes, block->size);
+  free(block);
+}
 
-  // Other files are actually closed
-  open_files[fd].mode = -1;
-  open_files[fd].entref = NULL;
-  return 0;
+static void share_dedup_block(struct DedupBlock *block) {
+/* Takes another reference to a shared block the caller already holds one to. */
+  int *lock = &dedup_buckets[block->hash % DEDUP_BUCKETS].lock;
+  spin_lock(lock);
+  ++block->refs;
+  spin_unlock(lock);
+  add_stat(&__vramfs_dedup_stats.blocks_shared, 1);
+  add_stat(&__vramfs_dedup_stats.logical_bytes, block->size);
 }
 
+static struct DedupBlock *acquire_dedup_block(const char *data, size_t len) {
+/* Returns a reference to the shared block with the given contents, storing it if it
+ * isn't in the block store yet. Returns NULL if out of memory.
+ */
+  unsigned long long hash = hash_block(data, len);
+  int *lock = &dedup_buckets[hash % DEDUP_BUCKETS].lock;
+  struct DedupBlock **bucket = &dedup_buckets[hash % DEDUP_BUCKETS].blocks;
+  struct DedupBlock *block;
+
+  spin_lock(lock);
+  for (block = *bucket; block; block = block->next) {
+    if (block->hash == hash && block->size == len && !memcmp(block->data, data, len)) {
+      ++block->refs;
+      spin_unlock(lock);
+      add_stat(&__vramfs_dedup_stats.blocks_shared, 1);
+      add_stat(&__vramfs_dedup_stats.logical_bytes, len);
+      return block;
+    }
+  }
 
-int
-fstat (int fd, struct stat *buf) {
-  return -1;
+  block = malloc(sizeof(struct DedupBlock) + len);
+  if (!block) {
+    spin_unlock(lock);
+    return NULL;
+  }
+
+  block->hash = hash;
+  block->refs = 1;
+  block->size = len;
+  memcpy(block->data, data, len);
+  block->next = *bucket;
+  *bucket = block;
+  spin_unlock(lock);
+  add_stat(&__vramfs_dedup_stats.logical_bytes, len);
+  add_stat(&__vramfs_dedup_stats.stored_bytes, len);
+  return block;
 }
 
+static void drop_dedup(struct Entry *entref) {
+/* Releases the shared blocks of the entry, if any. The number of blocks follows from
+ * entref->size, so this has to happen before the size changes.
+ */
+  if (!entref->dblocks)
+    return;
+
+  size_t nblocks = (entref->size + DEDUP_BLOCK - 1) / DEDUP_BLOCK;
+  for (size_t i = 0; i < nblocks; ++i)
+    release_dedup_block(entref->dblocks[i]);
+  free(entref->dblocks);
+  entref->dblocks = NULL;
+}
 
-int
-gettimeofday (struct timeval *tv, void *tz) {
-  return -1;
+static int dedup_entry(struct Entry *entref) {
+/* Replaces the data of the entry by references to shared blocks. Returns 0 if the
+ * entry was deduplicated.
+ */
+  if (entref->dblocks || !entref->data || !entref->size || data_is_inline(entref))
+    return ERR_INVALID;
+
+  unsigned long long start = read_clock64();
+  size_t nblocks = (entref->size + DEDUP_BLOCK - 1) / DEDUP_BLOCK;
+  struct DedupBlock **dblocks = malloc(nblocks * sizeof(struct DedupBlock *));
+  int errcode = ERR_NO_SPACE;
+
+  if (!dblocks)
+    goto out;
+
+  for (size_t i = 0; i < nblocks; ++i) {
+    size_t from = i * DEDUP_BLOCK;
+    size_t len = entref->size - from < DEDUP_BLOCK ? entref->size - from : DEDUP_BLOCK;
+
+    dblocks[i] = acquire_dedup_block(entref->data + from, len);
+    if (!dblocks[i]) {
+      while (i--)
+        release_dedup_block(dblocks[i]);
+      free(dblocks);
+      goto out;
+    }
+  }
+
+  pool_entry_data(entref);
+  entref->dblocks = dblocks;
+  errcode = 0;
+
+out:
+  add_stat(&__vramfs_dedup_stats.hash_cycles, read_clock64() - start);
+  return errcode;
 }
 
+static int dedup_closed_entry(struct Entry *entref) {
+/* Deduplicates a regular file that isn't open. The caller holds the lock of the shard
+ * owning its slot, so the file can't be opened and read while its data is swapped for
+ * the shared blocks.
+ */
+  return entry_is_closed(entref) ? dedup_entry(entref) : ERR_BUSY;
+}
 
-int
-getpid (void) {
+static int undedup_entry(struct Entry *entref) {
+/* Gives a deduplicated entry a private copy of its data, before it gets modified. */
+  char *data = malloc(entref->size);
+  if (!data)
+    return ERR_NO_SPACE;
+
+  for (size_t i = 0; i * DEDUP_BLOCK < entref->size; ++i)
+    memcpy(data + i * DEDUP_BLOCK, entref->dblocks[i]->data, entref->dblocks[i]->size);
+
+  drop_dedup(entref);
+  entref->data = data;
+  entref->capacity = entref->size;
   return 0;
 }
 
-
-int
-isatty (int fd) {
-  return fd == 1;
+#else
+// Compression and deduplication are compiled out, files always keep their data in place
+static void drop_compressed(struct Entry *entref) {
+  (void)entref;
 }
 
+static int compress_entry(struct Entry *entref) {
+  (void)entref;
+  return ERR_INVALID;
+}
 
-int
-kill (int pid, int sig) {
-  errno = ESRCH;
-  return -1;
+static int inflate_entry(struct Entry *entref) {
+  (void)entref;
+  return 0;
 }
 
+static int compress_closed_entry(struct Entry *entref) {
+  (void)entref;
+  return ERR_INVALID;
+}
 
-off_t
-lseek(int fd, off_t offset, int whence) {
+static int compress_cold_entries(const struct Entry *except) {
+  (void)except;
   return 0;
 }
 
+static void drop_dedup(struct Entry *entref) {
+  (void)entref;
+}
 
-int
-open (const char *pathname, int flags, ...) {
-  #ifdef __test__
-  __test();
-  #endif
+static int dedup_entry(struct Entry *entref) {
+  (void)entref;
+  return ERR_INVALID;
+}
 
-  int fd;
-  for (fd = UNRESERVED_FD_START; fd < MAX_FOPEN; ++fd) {
+static int dedup_closed_entry(struct Entry *entref) {
+  (void)entref;
+  return ERR_INVALID;
+}
 
-    // mode = -1 will always mean an empty slot in the file table of open_files
-    if (open_files[fd].mode == -1)
-      break;
+static int undedup_entry(struct Entry *entref) {
+  (void)entref;
+  return 0;
+}
+#endif
+
+static int entry_chunk(struct Entry *entref, size_t offset, const char **chunk_ref, size_t *len_ref) {
+/* Points *chunk_ref at the entry's data from the given offset (below the size) on, and
+ * sets *len_ref to the number of bytes that are contiguous there: the rest of the file,
+ * or of the shared block. For compressed entries, the block is decompressed into the
+ * entry's single block cache.
+ */
+#ifndef VRAMFS_PROFILE_BASIC
+  if (entref->dblocks) {
+    struct DedupBlock *block = entref->dblocks[offset / DEDUP_BLOCK];
+    size_t within = offset % DEDUP_BLOCK;
+    *chunk_ref = block->data + within;
+    *len_ref = block->size - within;
+    return 0;
   }
 
-  if (fd == MAX_FOPEN) {
-    errno = ENFILE;
-    return -1;
+  if (!entref->zdata) {
+#endif
+    *chunk_ref = entref->data + offset;
+    *len_ref = entref->size - offset;
+    return 0;
+#ifndef VRAMFS_PROFILE_BASIC
   }
 
-  struct Entry *entref;
-  int errcode = find_entry(pathname, &entref);
-  
-  // Do not allow opening the file if the file exists and is open (set EACCES)
-  if (errcode != ERR_ENTRY_NOT_FOUND) {
-    int spal;
-    for (spal = 0; spal < MAX_FOPEN; ++spal) {
-      if (entref->name == (open_files[spal].entref)->name) {
-        errno = EACCES;
-        return -1;
-      }
-    }
+  if (!entref->zcache) {
+    entref->zcache = malloc(COMPRESS_BLOCK);
+    if (!entref->zcache)
+      return ERR_NO_SPACE;
+    entref->zcache_block = (size_t)-1;
   }
 
-  switch (flags) {
-    case MODE_R:
+  size_t block = offset / COMPRESS_BLOCK;
+  size_t within = offset % COMPRESS_BLOCK;
+  if (entref->zcache_block != block) {
+    unsigned long long start = read_clock64();
+    entref->zcache_block = (size_t)-1;
+    if (inflate_block(entref, block, entref->zcache))
+      return ERR_INVALID;
+    entref->zcache_block = block;
+    add_stat(&__vramfs_compress_stats.blocks_inflated, 1);
+    add_stat(&__vramfs_compress_stats.decompress_cycles, read_clock64() - start);
+  }
+
+  *chunk_ref = entref->zcache + within;
+  *len_ref = zblock_size(entref, block) - within;
+  return 0;
+#endif
+}
+
+static int entry_copy_out(struct Entry *entref, size_t offset, void *buf, size_t count) {
+/* Copies count bytes from the given offset of the entry's data into buf. For compressed
+ * entries, only the blocks covering the range are decompressed, one at a time, through
+ * the entry's single block cache.
+ */
+  char *cbuf = (char *)buf;
+
+  while (count) {
+    const char *chunk;
+    size_t n;
+    int errcode = entry_chunk(entref, offset, &chunk, &n);
+    if (errcode)
+      return errcode;
+
+    if (n > count)
+      n = count;
+    memcpy(cbuf, chunk, n);
+    cbuf += n;
+    offset += n;
+    count -= n;
+  }
+  return 0;
+}
+
+static unsigned int hash_name(const struct Entry *parent, const char *name, size_t len) {
+/* FNV-1a of the name, seeded with the parent, so that equal names in different
+ * directories land on different chains.
+ */
+  unsigned long long hash = 0xcbf29ce484222325ull ^ (uintptr_t)parent;
+  for (size_t i = 0; i < len; ++i) {
+    hash ^= (unsigned char)name[i];
+    hash *= 0x100000001b3ull;
+  }
+  return (unsigned int)(hash ^ (hash >> 32));
+}
+
+static void spin_lock(int *lock) {
+/* Threads of one warp that contend for a lock rely on independent thread scheduling
+ * (sm_70 and up) to make progress.
+ */
+  while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE))
+    ;
+}
+
+static int spin_trylock(int *lock) {
+  return !__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE);
+}
+
+static void spin_unlock(int *lock) {
+  __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+static struct Shard *shard_of(unsigned int hash) {
+  return shards + hash % NSHARDS;
+}
+
+static struct Entry **bucket_of(unsigned int hash) {
+  return &shard_of(hash)->buckets[hash / NSHARDS % NAME_BUCKETS];
+}
+
+static struct Shard *slot_shard(const struct Entry *entref) {
+/* The shard owning the slot of an entry in vramfs. */
+  return shards + (entref - vramfs) / SHARD_FILES;
+}
+
+static void lock_shards(struct Shard *a, struct Shard *b) {
+  if (a == b) {
+    spin_lock(&a->lock);
+    return;
+  }
+  spin_lock(a < b ? &a->lock : &b->lock);
+  spin_lock(a < b ? &b->lock : &a->lock);
+}
+
+static void unlock_shards(struct Shard *a, struct Shard *b) {
+  spin_unlock(&a->lock);
+  if (a != b)
+    spin_unlock(&b->lock);
+}
+
+static struct Shard *lock_entry_shards(struct Entry *entref) {
+/* Locks the shard of the entry's slot and the shard of its name index chain, and
+ * returns the latter. The name may move under us until both are locked.
+ */
+  for (;;) {
+    unsigned int hash = __atomic_load_n(&entref->name_hash, __ATOMIC_RELAXED);
+    lock_shards(shard_of(hash), slot_shard(entref));
+    if (entref->name_hash == hash)
+      return shard_of(hash);
+    unlock_shards(shard_of(hash), slot_shard(entref));
+  }
+}
+
+static struct Entry *entry_inode(struct Entry *entref) {
+/* The entry holding the file a name refers to. */
+  return entref->inode ? entref->inode : entref;
+}
+
+static struct Entry *lookup_chain(struct Entry *dir, const char *name, size_t len, unsigned int hash) {
+/* Returns the live entry called name (len bytes, not nul-terminated) in dir from the
+ * name index chain for hash, or NULL. The caller holds the lock of the shard.
+ */
+  for (struct Entry *entref = *bucket_of(hash); entref; entref = entref->hash_next) {
+    if (entref->parent == dir && entry_is_live(entref)
+        && !strncmp(entref->name, name, len) && entref->name[len] == '\0')
+      return entref;
+  }
+  return NULL;
+}
+
+static int link_entry(struct Entry *parent, struct Entry *entref) {
+/* Adds the entry, whose name and name_hash are set, to the directory parent and to the
+ * name index. The caller holds the lock of the entry's shard. Fails if parent has been
+ * removed in the meantime.
+ */
+  spin_lock(&parent->lock);
+  if (parent->type != ENT_TYPE_DIRECTORY || !entry_is_live(parent)) {
+    spin_unlock(&parent->lock);
+    return ERR_ENTRY_NOT_FOUND;
+  }
+  entref->parent = parent;
+  entref->parent_incarnation = parent->incarnation;
+  entref->name_gen = __atomic_add_fetch(&fs_generation, 1, __ATOMIC_RELAXED);
+  entref->prev_sibling = NULL;
+  entref->next_sibling = parent->children;
+  if (parent->children)
+    parent->children->prev_sibling = entref;
+  parent->children = entref;
+  spin_unlock(&parent->lock);
+
+  struct Entry **bucket = bucket_of(entref->name_hash);
+  entref->hash_next = *bucket;
+  *bucket = entref;
+  return 0;
+}
+
+static void unlink_entry(struct Entry *entref) {
+/* Removes the entry from its directory and from the name index. The caller holds the
+ * lock of the entry's shard.
+ */
+  struct Entry *parent = entref->parent;
+  if (!parent)
+    return;
+
+  struct Entry **link = bucket_of(entref->name_hash);
+  while (*link && *link != entref)
+    link = &(*link)->hash_next;
+  if (*link)
+    *link = entref->hash_next;
+  entref->hash_next = NULL;
+
+  // A directory that was removed or reused has abandoned its old list of children
+  spin_lock(&parent->lock);
+  if (entref->parent_incarnation == parent->incarnation) {
+    if (entref->prev_sibling)
+      entref->prev_sibling->next_sibling = entref->next_sibling;
+    else
+      parent->children = entref->next_sibling;
+    if (entref->next_sibling)
+      entref->next_sibling->prev_sibling = entref->prev_sibling;
+  }
+  spin_unlock(&parent->lock);
+
+  entref->prev_sibling = NULL;
+  entref->next_sibling = NULL;
+  entref->parent = NULL;
+}
+
+static void flush_dentry_cache(void) {
+  __atomic_add_fetch(&dentry_cache_gen, 1, __ATOMIC_RELEASE);
+}
+
+static void abandon_children(struct Entry *dir) {
+/* Empties the list of children of a directory that is going away. Whatever is still
+ * in it is stale (a live entry has live ancestors), and is left to be reclaimed with
+ * its own shard; the new incarnation tells unlink_entry() not to touch the old list.
+ */
+  spin_lock(&dir->lock);
+  dir->children = NULL;
+  ++dir->incarnation;
+  spin_unlock(&dir->lock);
+  flush_dentry_cache();
+}
+
+static void init_builtin(struct Entry *entref, const char *name, int type, const struct EntryOps *ops) {
+  strncpy(entref->name, name, MAX_FNAME);
+  entref->type = type;
+  entref->ops = ops;
+}
+
+static void init_namespace(void) {
+/* Sets up the root directory, /dev, the devices and the standard streams, links them
+ * together and fills the free lists on first use. Threads that arrive while this is
+ * under way wait for it.
+ */
+  int state = __atomic_load_n(&namespace_state, __ATOMIC_ACQUIRE);
+  if (state == 2)
+    return;
+
+  if (state == 0 && __atomic_compare_exchange_n(&namespace_state, &state, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+    init_builtin(&root_dir, "", ENT_TYPE_DIRECTORY, &dir_ops);
+    init_builtin(&dev_entries[0], "dev", ENT_TYPE_DIRECTORY, &dir_ops);
+    init_builtin(&dev_entries[1], "null", ENT_TYPE_DEVICE, &devnull_ops);
+    init_builtin(&dev_entries[2], "zero", ENT_TYPE_DEVICE, &devzero_ops);
+    init_builtin(&dev_entries[3], "urandom", ENT_TYPE_DEVICE, &devurandom_ops);
+    init_builtin(&stdio_entries[0], "/dev/stdin", ENT_TYPE_STREAM, &stdin_ops);
+    init_builtin(&stdio_entries[1], "/dev/stdout", ENT_TYPE_STREAM, &stdout_ops);
+    init_builtin(&stdio_entries[2], "/dev/stderr", ENT_TYPE_STREAM, &stdout_ops);
+    for (int fd = 0; fd < UNRESERVED_FD_START; ++fd) {
+      stdio_files[fd].mode = MODE_RW_TRUNC;
+      stdio_files[fd].entref = &stdio_entries[fd];
+    }
+
+    root_dir.parent = &root_dir;
+    for (size_t i = 0; i < NDEV_ENTRIES; ++i) {
+      struct Entry *parent = i ? &dev_entries[0] : &root_dir;
+      dev_entries[i].name_hash = hash_name(parent, dev_entries[i].name, strlen(dev_entries[i].name));
+      link_entry(parent, &dev_entries[i]);
+    }
+
+    for (int i = MAX_FILES - 1; i >= 0; --i) {
+      struct Shard *shard = shards + i / SHARD_FILES;
+      vramfs[i].hash_next = shard->free_list;
+      shard->free_list = vramfs + i;
+    }
+
+    __atomic_store_n(&namespace_state, 2, __ATOMIC_RELEASE);
+    return;
+  }
+
+  while (__atomic_load_n(&namespace_state, __ATOMIC_ACQUIRE) != 2)
+    ;
+}
+
+static struct Entry *lookup_child(struct Entry *dir, const char *name, size_t len) {
+/* Returns the live entry called name (len bytes, not nul-terminated) in dir, or NULL. */
+  if (len == 1 && name[0] == '.')
+    return dir;
+  if (len == 2 && name[0] == '.' && name[1] == '.')
+    return dir->parent;
+
+  unsigned int hash = hash_name(dir, name, len);
+  struct Shard *shard = shard_of(hash);
+  spin_lock(&shard->lock);
+  struct Entry *entref = lookup_chain(dir, name, len, hash);
+  spin_unlock(&shard->lock);
+  return entref;
+}
+
+static int walk_path(const char *path, size_t len, struct Entry **dir_ref) {
+/* Resolves the first len bytes of path, component by component, to a directory. */
+  struct Entry *dir = &root_dir;
+
+  for (size_t start = 0, end; start < len; start = end + 1) {
+    for (end = start; end < len && path[end] != '/'; ++end)
+      ;
+    if (end == start)
+      continue;
+    if (end - start >= MAX_FNAME)
+      return ERR_NAME_TOO_LONG;
+
+    dir = lookup_child(dir, path + start, end - start);
+    if (!dir)
+      return ERR_ENTRY_NOT_FOUND;
+    if (dir->type != ENT_TYPE_DIRECTORY)
+      return ERR_NOT_DIR;
+  }
+
+  *dir_ref = dir;
+  return 0;
+}
+
+static int lookup_dir(const char *path, size_t len, struct Entry **dir_ref) {
+/* walk_path() through the dentry cache. */
+  unsigned int gen = __atomic_load_n(&dentry_cache_gen, __ATOMIC_ACQUIRE);
+
+  for (int i = 0; i < DCACHE_SLOTS; ++i) {
+    struct DentryCacheSlot *slot = dentry_cache + i;
+    if (!spin_trylock(&slot->lock))
+      continue;
+    int hit = slot->dir && slot->gen == gen && slot->epoch == fs_epoch
+              && slot->len == len && !memcmp(slot->path, path, len);
+    if (hit)
+      *dir_ref = slot->dir;
+    spin_unlock(&slot->lock);
+    if (hit)
+      return 0;
+  }
+
+  int errcode = walk_path(path, len, dir_ref);
+  if (errcode || len > MAX_PATH)
+    return errcode;
+
+  // The generation from before the walk, so that a flush during the walk invalidates the result
+  unsigned int next = __atomic_fetch_add(&dentry_cache_next, 1, __ATOMIC_RELAXED);
+  struct DentryCacheSlot *slot = dentry_cache + next % DCACHE_SLOTS;
+  if (spin_trylock(&slot->lock)) {
+    slot->dir = *dir_ref;
+    slot->gen = gen;
+    slot->epoch = fs_epoch;
+    slot->len = len;
+    memcpy(slot->path, path, len);
+    spin_unlock(&slot->lock);
+  }
+  return 0;
+}
+
+static int resolve_path(const char *path, struct Entry **parent_ref, const char **base_ref, size_t *base_len_ref, struct Entry **entref_ref) {
+/* Resolves path to the directory containing its last component, the last component
+ * itself (not nul-terminated), and the entry it names. Paths are relative to the root
+ * directory whether or not they start with '/', and "." and ".." are understood.
+ * If only the last component doesn't exist, ERR_ENTRY_NOT_FOUND is returned with
+ * everything but *entref_ref filled in, so that the caller may create it; otherwise
+ * *parent_ref is left NULL on errors.
+ */
+  if (!path)
+    return ERR_NULLPTR;
+
+  init_namespace();
+  *parent_ref = NULL;
+
+  int is_root = *path == '/';
+  while (*path == '/')
+    ++path;
+  size_t len = strlen(path);
+  while (len && path[len - 1] == '/')
+    --len;
+
+  if (!len) {
+    if (!is_root)
+      return ERR_ENTRY_NOT_FOUND;
+    *parent_ref = &root_dir;
+    *base_ref = path;
+    *base_len_ref = 0;
+    *entref_ref = &root_dir;
+    return 0;
+  }
+
+  size_t dir_len = len;
+  while (dir_len && path[dir_len - 1] != '/')
+    --dir_len;
+  if (len - dir_len >= MAX_FNAME)
+    return ERR_NAME_TOO_LONG;
+
+  const char *base = path + dir_len;
+  while (dir_len && path[dir_len - 1] == '/')
+    --dir_len;
+
+  struct Entry *parent = &root_dir;
+  int errcode = dir_len ? lookup_dir(path, dir_len, &parent) : 0;
+  if (errcode)
+    return errcode;
+
+  *parent_ref = parent;
+  *base_ref = base;
+  *base_len_ref = len - (base - path);
+  *entref_ref = lookup_child(parent, base, *base_len_ref);
+  return *entref_ref ? 0 : ERR_ENTRY_NOT_FOUND;
+}
+
+static int find_entry(const char *name, struct Entry **entref_ptr) {
+/* Searches for the entry with the given path in the file system. Besides the
+ * errors of resolve_path(), ERR_ENTRY_NOT_FOUND is returned if a directory
+ * leading up to the entry doesn't exist.
+ */
+  if (!name || !entref_ptr)
+    return ERR_NULLPTR;
+
+  struct Entry *parent;
+  const char *base;
+  size_t base_len;
+  return resolve_path(name, &parent, &base, &base_len, entref_ptr);
+}
+
+static char *take_pooled_buffer(size_t size, size_t *capacity_ref) {
+/* Takes the smallest pooled buffer of at least size bytes from the size class of size,
+ * or failing that from the next one, whose buffers are all large enough. Larger buffers
+ * are left to files that need them. Returns NULL if there is none.
+ */
+  int first = pool_bucket(size);
+  int last = first < POOL_BUCKETS - 1 ? first + 1 : first;
+  for (int bucket = first; bucket <= last; ++bucket) {
+    spin_lock(&buffer_pool[bucket].lock);
+    int best = -1;
+    for (int i = 0; i < POOL_DEPTH; ++i) {
+      if (buffer_pool[bucket].slots[i].data && buffer_pool[bucket].slots[i].capacity >= size
+          && (best < 0 || buffer_pool[bucket].slots[i].capacity < buffer_pool[bucket].slots[best].capacity))
+        best = i;
+    }
+
+    char *data = NULL;
+    if (best >= 0) {
+      data = buffer_pool[bucket].slots[best].data;
+      *capacity_ref = buffer_pool[bucket].slots[best].capacity;
+      buffer_pool[bucket].slots[best].data = NULL;
+      buffer_pool[bucket].slots[best].capacity = 0;
+    }
+    spin_unlock(&buffer_pool[bucket].lock);
+    if (data)
+      return data;
+  }
+  return NULL;
+}
+
+static int drain_pool(void) {
+/* Frees all pooled buffers, to make room on the heap. Returns 1 if there were any. */
+  int drained = 0;
+  for (int bucket = 0; bucket < POOL_BUCKETS; ++bucket) {
+    spin_lock(&buffer_pool[bucket].lock);
+    for (int i = 0; i < POOL_DEPTH; ++i) {
+      if (buffer_pool[bucket].slots[i].data) {
+        free(buffer_pool[bucket].slots[i].data);
+        buffer_pool[bucket].slots[i].data = NULL;
+        buffer_pool[bucket].slots[i].capacity = 0;
+        drained = 1;
+      }
+    }
+    spin_unlock(&buffer_pool[bucket].lock);
+  }
+  return drained;
+}
+
+static struct Entry *take_slot(struct Shard *shard) {
+/* Takes a slot of the shard for a new entry: a free one if there is any, otherwise a
+ * stale one, which is reclaimed now. Only regular files and directories go stale, so a
+ * reclaimed data buffer is always the file's own. The caller holds the lock of the shard.
+ */
+  struct Entry *entref = shard->free_list;
+  if (entref) {
+    shard->free_list = entref->hash_next;
+    entref->hash_next = NULL;
+    entref->data = NULL;
+    entref->capacity = 0;
+    return entref;
+  }
+
+  struct Entry *slots = vramfs + (shard - shards) * SHARD_FILES;
+  for (int i = 0; i < SHARD_FILES; ++i) {
+    entref = slots + i;
+    if (entref->type == ENT_TYPE_FREE || entry_is_live(entref))
+      continue;
+
+    /* A renamed entry's name may be on the chain of another shard, which we can only
+     * try to lock here; if that fails, we move on to the next stale slot.
+     */
+    struct Shard *chain = entref->parent ? shard_of(entref->name_hash) : shard;
+    if (chain != shard && !spin_trylock(&chain->lock))
+      continue;
+
+    // A stale file from an older epoch hands its data buffer on to the new one
+    if (entref->type == ENT_TYPE_DIRECTORY)
+      abandon_children(entref);
+    unlink_entry(entref);
+    if (chain != shard)
+      spin_unlock(&chain->lock);
+
+    drop_compressed(entref);
+    drop_dedup(entref);
+    free(entref->block_gen);
+    entref->block_gen = NULL;
+    entref->nblocks = 0;
+    return entref;
+  }
+  return NULL;
+}
+
+static void free_slot(struct Shard *shard, struct Entry *entref) {
+/* Returns an unlinked slot to the free list of its shard, and its data buffer to the
+ * pool. The caller holds the lock of the shard.
+ */
+  pool_entry_data(entref);
+  entref->size = 0;
+  entref->name[0] = '\0';
+  entref->type = ENT_TYPE_FREE;
+  entref->ops = NULL;
+  entref->hash_next = shard->free_list;
+  shard->free_list = entref;
+}
+
+static int alloc_entry(struct Entry *parent, const char *name, size_t len, int type, const struct EntryOps *ops,
+                       char *data, struct Entry *inode, struct Entry **entref_ptr) {
+/* Creates an entry called name (len bytes) in the directory parent, in the shard its
+ * name hashes to. ops is NULL for the default operations of type, and data NULL for a
+ * file that gets its own buffer. inode is NULL, except for a hard link, whose caller
+ * accounts for the new name in inode->nlink. The entry is complete before it is linked.
+ * If another thread created it since it was looked up, ERR_EXISTS is returned along
+ * with the entry.
+ */
+  unsigned int hash = hash_name(parent, name, len);
+  struct Shard *shard = shard_of(hash);
+  spin_lock(&shard->lock);
+
+  struct Entry *entref = lookup_chain(parent, name, len, hash);
+  if (entref) {
+    spin_unlock(&shard->lock);
+    *entref_ptr = entref;
+    return ERR_EXISTS;
+  }
+
+  entref = take_slot(shard);
+  if (!entref) {
+    spin_unlock(&shard->lock);
+    return ERR_ENTRIES_EXHAUSTED;
+  }
+
+  memcpy(entref->name, name, len);
+  entref->name[len] = '\0';
+  entref->name_hash = hash;
+  entref->size = 0;
+  entref->inode = inode;
+  entref->nlink = type == ENT_TYPE_REGULAR && !inode;
+  entref->type = type;
+  entref->ops = ops ? ops : type == ENT_TYPE_DIRECTORY ? &dir_ops : &regular_ops;
+  if (data) {
+    pool_entry_data(entref);
+    entref->data = data;
+  }
+  entref->epoch = fs_epoch;
+  entref->nopen = 0;
+  entref->children = NULL;
+  ++entref->incarnation;
+  entref->gen = __atomic_add_fetch(&fs_generation, 1, __ATOMIC_RELAXED);
+
+  int errcode = link_entry(parent, entref);
+  if (errcode)
+    free_slot(shard, entref);
+  else
+    *entref_ptr = entref;
+
+  spin_unlock(&shard->lock);
+  return errcode;
+}
+
+static int init_entry(const char *name, struct Entry **entref_ptr) {
+/* Initializes an empty regular file in the file system with the given path.
+ * It is assumed that an entry with the given path doesn't exist in the file
+ * system, but its directory must. Caller should verify this by running find_entry().
+ */
+  if (!name || !entref_ptr)
+    return ERR_NULLPTR;
+
+  struct Entry *parent, *entref;
+  const char *base;
+  size_t base_len;
+  int errcode = resolve_path(name, &parent, &base, &base_len, &entref);
+  if (errcode != ERR_ENTRY_NOT_FOUND)
+    return errcode ? errcode : ERR_EXISTS;
+  if (!parent)
+    return ERR_ENTRY_NOT_FOUND;
+
+  return alloc_entry(parent, base, base_len, ENT_TYPE_REGULAR, NULL, NULL, NULL, entref_ptr);
+}
+
+static void release_if_unused(struct Entry *inode) {
+/* Frees a regular file that has lost its last name once it isn't open anymore either.
+ * Whichever of unlink() and close() comes last gets here with both counts at 0.
+ */
+  struct Shard *shard = slot_shard(inode);
+  spin_lock(&shard->lock);
+  if (inode->type == ENT_TYPE_REGULAR && !inode->inode && !inode->parent && entry_is_live(inode)
+      && !__atomic_load_n(&inode->nlink, __ATOMIC_ACQUIRE) && !__atomic_load_n(&inode->nopen, __ATOMIC_ACQUIRE)) {
+    drop_compressed(inode);
+    drop_dedup(inode);
+    free(inode->block_gen);
+    inode->block_gen = NULL;
+    inode->nblocks = 0;
+    free_slot(shard, inode);
+  }
+  spin_unlock(&shard->lock);
+}
+
+static int pin_inode(struct Entry *inode, unsigned int *count) {
+/* Counts another open file or name in *count, which is inode->nopen or inode->nlink,
+ * unless the file has lost its last name since it was looked up. A regular file is open
+ * at most once, so ERR_BUSY is returned if *count is nopen and the file is already open;
+ * the test and the count are one step under the shard lock, or two teams could both
+ * open the file.
+ */
+  struct Shard *shard = slot_shard(inode);
+  spin_lock(&shard->lock);
+  int errcode = 0;
+  if (inode->type != ENT_TYPE_REGULAR || !entry_is_live(inode) || !__atomic_load_n(&inode->nlink, __ATOMIC_ACQUIRE))
+    errcode = ERR_ENTRY_NOT_FOUND;
+  else if (count == &inode->nopen && __atomic_load_n(count, __ATOMIC_ACQUIRE))
+    errcode = ERR_BUSY;
+  else
+    __atomic_add_fetch(count, 1, __ATOMIC_ACQ_REL);
+  spin_unlock(&shard->lock);
+  return errcode;
+}
+
+static int remove_name(struct Entry *entref) {
+/* Removes a name of a regular file. A hard link's own slot is freed right away, the
+ * file's data stays until its last name is gone and it isn't open anymore.
+ */
+  struct Shard *chain = lock_entry_shards(entref);
+  struct Shard *shard = slot_shard(entref);
+
+  // Another thread may have removed it since it was looked up
+  if (entref->type != ENT_TYPE_REGULAR || !entry_is_live(entref) || !entref->parent) {
+    unlock_shards(chain, shard);
+    return ERR_ENTRY_NOT_FOUND;
+  }
+
+  struct Entry *inode = entry_inode(entref);
+  record_removal(entref);
+  unlink_entry(entref);
+  if (entref != inode)
+    free_slot(shard, entref);
+  unlock_shards(chain, shard);
+
+  if (!__atomic_sub_fetch(&inode->nlink, 1, __ATOMIC_ACQ_REL))
+    release_if_unused(inode);
+  return 0;
+}
+
+static int remove_dir(struct Entry *entref) {
+/* Removes an empty directory. The root directory and /dev stay. */
+  if (entref == &root_dir || entref == &dev_entries[0])
+    return ERR_BUSY;
+
+  struct Shard *chain = lock_entry_shards(entref);
+  struct Shard *shard = slot_shard(entref);
+
+  // Another thread may have removed it since it was looked up
+  if (entref->type != ENT_TYPE_DIRECTORY || !entry_is_live(entref)) {
+    unlock_shards(chain, shard);
+    return ERR_ENTRY_NOT_FOUND;
+  }
+
+  // Only stale entries may be left in a directory that is removed
+  spin_lock(&entref->lock);
+  for (struct Entry *child = entref->children; child; child = child->next_sibling) {
+    if (entry_is_live(child)) {
+      spin_unlock(&entref->lock);
+      unlock_shards(chain, shard);
+      return ERR_NOT_EMPTY;
+    }
+  }
+  entref->type = ENT_TYPE_FREE;
+  spin_unlock(&entref->lock);
+
+  record_removal(entref);
+  abandon_children(entref);
+  unlink_entry(entref);
+  free_slot(shard, entref);
+  unlock_shards(chain, shard);
+  return 0;
+}
+
+static int move_entry(struct Entry *entref, struct Entry *parent, const char *name, size_t len) {
+/* Gives the entry the new name name (len bytes) in the directory parent. Only its name
+ * moves, from the name index chain of the old name to the one of the new name; the
+ * slot and the data stay where they are.
+ */
+  unsigned int hash = hash_name(parent, name, len);
+  unsigned int old_hash;
+  for (;;) {
+    old_hash = __atomic_load_n(&entref->name_hash, __ATOMIC_RELAXED);
+    lock_shards(shard_of(old_hash), shard_of(hash));
+    if (entref->name_hash == old_hash)
+      break;
+    unlock_shards(shard_of(old_hash), shard_of(hash));
+  }
+
+  int errcode = 0;
+  int type = entref->type;
+  struct Entry *old_parent = entref->parent;
+  if (!entry_is_live(entref) || !old_parent)
+    errcode = ERR_ENTRY_NOT_FOUND;
+  else if (lookup_chain(parent, name, len, hash))
+    errcode = ERR_EXISTS;
+  if (errcode) {
+    unlock_shards(shard_of(old_hash), shard_of(hash));
+    return errcode;
+  }
+
+  // The old path goes away; if the move fails, relinking gives it back a new generation
+  char old_name[MAX_FNAME];
+  memcpy(old_name, entref->name, MAX_FNAME);
+  record_removal(entref);
+  unlink_entry(entref);
+  memcpy(entref->name, name, len);
+  entref->name[len] = '\0';
+  __atomic_store_n(&entref->name_hash, hash, __ATOMIC_RELAXED);
+  errcode = link_entry(parent, entref);
+
+  // The new directory was removed meanwhile, so the entry goes back where it was
+  int lost = 0;
+  if (errcode) {
+    memcpy(entref->name, old_name, MAX_FNAME);
+    __atomic_store_n(&entref->name_hash, old_hash, __ATOMIC_RELAXED);
+    lost = link_entry(old_parent, entref) != 0;
+  }
+  unlock_shards(shard_of(old_hash), shard_of(hash));
+
+  if (type == ENT_TYPE_DIRECTORY)
+    flush_dentry_cache();
+
+  /* If the old directory was removed as well, which it may have been once it looked
+   * empty, the name is gone. A directory lost this way is unreachable until the next
+   * __vramfs_reset() reclaims it.
+   */
+  if (lost && type == ENT_TYPE_REGULAR) {
+    struct Entry *inode = entry_inode(entref);
+    if (entref != inode) {
+      struct Shard *shard = slot_shard(entref);
+      spin_lock(&shard->lock);
+      free_slot(shard, entref);
+      spin_unlock(&shard->lock);
+    }
+    if (!__atomic_sub_fetch(&inode->nlink, 1, __ATOMIC_ACQ_REL))
+      release_if_unused(inode);
+  }
+  return errcode;
+}
+
+static int clear_entry(struct Entry *entref) {
+ /* Clears the data & metadata of the file system entry without removing it.
+  * The name is left intact. Devices and streams have nothing to clear.
+  * The data buffer stays with the file for its next contents, unless it's larger
+  * than TRUNC_RETAIN, and so does the array of block generations.
+  */
+  if (!entref)
+    return ERR_NULLPTR;
+
+  if (entref->type != ENT_TYPE_REGULAR)
+    return 0;
+
+  drop_compressed(entref);
+  drop_dedup(entref);
+  entref->size = 0;
+  if (entref->capacity > TRUNC_RETAIN)
+    pool_entry_data(entref);
+  entref->gen = __atomic_add_fetch(&fs_generation, 1, __ATOMIC_RELAXED);
+
+  // Blocks past the end are only looked at once they are written again
+  for (size_t i = 0; i < entref->nblocks; ++i)
+    entref->block_gen[i] = entref->gen;
+  return 0;
+}
+
+static void mark_dirty(struct Entry *entref, size_t start, size_t end) {
+/* Records that bytes [start, end) of the entry were modified in a new generation.
+ * Files of a single block are tracked by entref->gen alone. If the per-block array
+ * can't be grown, it is dropped, which makes the whole file count as modified at
+ * entref->gen; that's less compact but still correct.
+ */
+  unsigned long long prev_gen = entref->gen;
+  unsigned long long gen = __atomic_add_fetch(&fs_generation, 1, __ATOMIC_RELAXED);
+  entref->gen = gen;
+
+  if (end <= start)
+    return;
+
+  size_t nblocks = (entref->size + DIRTY_BLOCK - 1) / DIRTY_BLOCK;
+  if (nblocks <= 1 && !entref->block_gen)
+    return;
+
+  if (nblocks > entref->nblocks) {
+    unsigned long long *block_gen = realloc(entref->block_gen, nblocks * sizeof(unsigned long long));
+    if (!block_gen) {
+      free(entref->block_gen);
+      entref->block_gen = NULL;
+      entref->nblocks = 0;
+      return;
+    }
+
+    /* Blocks that existed before this write were last modified at prev_gen at the
+     * latest, and blocks that are new are all within [start, end) below.
+     */
+    for (size_t i = entref->nblocks; i < nblocks; ++i)
+      block_gen[i] = prev_gen;
+
+    entref->block_gen = block_gen;
+    entref->nblocks = nblocks;
+  }
+
+  for (size_t i = start / DIRTY_BLOCK; i < (end + DIRTY_BLOCK - 1) / DIRTY_BLOCK; ++i)
+    entref->block_gen[i] = gen;
+}
+
+static int read_entry_data(struct File *file, void *buf, size_t count, ssize_t *new_count_ref) {
+/* Read the data from the file system entry that file's entref points to. Reading is started
+ * from file's offset. Read data is copied into buf. On success, 0 is returned.
+ */
+  if ((!file) || (!file->entref) || (!buf))
+    return ERR_NULLPTR;
+
+  struct Entry *entref = file->entref;
+
+  // Nothing to read if the offset is at (or past) the end (no error)
+  if (file->offset >= entref->size) {
+    *new_count_ref = 0;
+    return 0;
+  }
+
+  if (count > entref->size - file->offset)
+    count = entref->size - file->offset;
+
+  int errcode = entry_copy_out(entref, file->offset, buf, count);
+  if (errcode)
+    return errcode;
+
+  *new_count_ref = count;
+  return 0;
+}
+
+static int reserve_entry(struct Entry *entref, size_t size) {
+/* Makes room for size bytes in the data buffer of a plain (neither compressed nor
+ * deduplicated) regular file, without changing its size.
+ */
+  if (size <= entref->capacity)
+    return 0;
+
+  // Small files don't need the heap at all
+  if (!entref->data && size <= INLINE_DATA) {
+    entref->data = entref->inline_data;
+    entref->capacity = INLINE_DATA;
+    return 0;
+  }
+
+  /* Buffers grow at least twice as large, up to GROW_MAX past size, so that a file
+   * built by small appends is copied a logarithmic number of times.
+   */
+  size_t capacity = size;
+  if (size < 2 * entref->capacity)
+    capacity = 2 * entref->capacity - size < GROW_MAX ? 2 * entref->capacity : size + GROW_MAX;
+
+  /* The file moves into a pooled buffer if there is one to fit, which saves going to the
+   * heap. Its old buffer, if it had one of its own, goes back to the pool.
+   */
+  int promote = data_is_inline(entref);
+  char *new_data = take_pooled_buffer(size, &capacity);
+  if (new_data) {
+    if (entref->data)
+      memcpy(new_data, entref->data, entref->size);
+    if (!promote)
+      pool_buffer(entref->data, entref->capacity);
+  }
+  else {
+    char *old_data = promote ? NULL : entref->data;
+    new_data = realloc(old_data, capacity);
+
+    // Under memory pressure, do without the room to grow, then empty the pool, then compress other files
+    if (!new_data && capacity > size) {
+      capacity = size;
+      new_data = realloc(old_data, size);
+    }
+    if (!new_data && drain_pool())
+      new_data = realloc(old_data, size);
+    if (!new_data && __vramfs_compress_threshold && compress_cold_entries(entref))
+      new_data = realloc(old_data, size);
+
+    if (!new_data)  // Probably out of memory
+      return ERR_NO_SPACE;
+    if (promote)
+      memcpy(new_data, entref->inline_data, entref->size);
+  }
+
+  entref->data = new_data;
+  entref->capacity = capacity;
+  return 0;
+}
+
+static int resize_entry(struct Entry *entref, size_t size) {
+/* Truncates a regular file to size bytes, or extends it with zeros. The storage past
+ * the new end is given back: all of it if the file becomes empty, otherwise by shrinking
+ * the buffer.
+ */
+  if (entref->zdata && inflate_entry(entref))
+    return ERR_NO_SPACE;
+  if (entref->dblocks && undedup_entry(entref))
+    return ERR_NO_SPACE;
+
+  size_t cur_size = entref->size;
+  if (size > cur_size) {
+    if (reserve_entry(entref, size))
+      return ERR_NO_SPACE;
+    memset(entref->data + cur_size, 0, size - cur_size);
+    entref->size = size;
+    mark_dirty(entref, cur_size, size);
+    return 0;
+  }
+
+  entref->size = size;
+  if (!size)
+    pool_entry_data(entref);
+  else if (size <= INLINE_DATA && !data_is_inline(entref)) {
+    memcpy(entref->inline_data, entref->data, size);
+    pool_entry_data(entref);
+    entref->data = entref->inline_data;
+    entref->capacity = INLINE_DATA;
+  }
+  else if (size < entref->capacity && !data_is_inline(entref)) {
+    char *new_data = realloc(entref->data, size);
+    if (new_data) {
+      entref->data = new_data;
+      entref->capacity = size;
+    }
+  }
+  mark_dirty(entref, size, size);
+  return 0;
+}
+
+static int prepare_write(struct Entry *entref, size_t offset, size_t count, size_t *dirty_ref) {
+/* Makes room in a regular file for count bytes at offset, which the caller then stores
+ * in entref->data. The file covers the range afterwards, with any gap between its old
+ * end and offset zero-filled. *dirty_ref is set to where the modified bytes start.
+ */
+  // Compressed and deduplicated files get a private, plain copy before they are modified
+  if (entref->zdata && inflate_entry(entref))
+    return ERR_NO_SPACE;
+  if (entref->dblocks && undedup_entry(entref))
+    return ERR_NO_SPACE;
+
+  size_t cur_size, new_size;
+  cur_size = entref->size;
+  new_size = offset + count;
+
+  if (new_size < offset)  // Overflow
+    return ERR_NO_SPACE;
+
+  if (reserve_entry(entref, new_size))
+    return ERR_NO_SPACE;
+
+  if (new_size > cur_size) {
+    if (offset > cur_size)
+      memset(entref->data + cur_size, 0, offset - cur_size);
+    entref->size = new_size;
+  }
+
+  *dirty_ref = offset < cur_size ? offset : cur_size;
+  return 0;
+}
+
+static int write_entry_data(struct File *file, const void *buf, size_t count, ssize_t *new_count_ref) {
+ /* Write the contents of buf to data of the file system entry that file's entref points to.
+  * Writing is started from the file's offset (or the end of the file for O_APPEND). Any gap
+  * between the old end of the file and the offset is zero-filled. On success, 0 is returned.
+  */
+  if ((!file) || (!file->entref) || (!buf))
+    return ERR_NULLPTR;
+
+  struct Entry *entref = file->entref;
+
+  if (file->mode & O_APPEND)
+    file->offset = entref->size;
+
+  size_t dirty;
+  int errcode = prepare_write(entref, file->offset, count, &dirty);
+  if (errcode)
+    return errcode;
+
+  memcpy(entref->data + file->offset, buf, count);
+  mark_dirty(entref, dirty, file->offset + count);
+  *new_count_ref = count;
+  return 0;
+}
+
+#ifndef VRAMFS_PROFILE_BASIC
+static int share_entry(struct Entry *dst, struct Entry *src) {
+/* Makes dst a copy of the whole of src by taking references to the shared blocks of
+ * src, which has to be deduplicated, instead of copying its data. dst loses all of
+ * its previous contents.
+ */
+  size_t nblocks = (src->size + DEDUP_BLOCK - 1) / DEDUP_BLOCK;
+  struct DedupBlock **dblocks = malloc(nblocks * sizeof(struct DedupBlock *));
+  if (!dblocks)
+    return ERR_NO_SPACE;
+
+  for (size_t i = 0; i < nblocks; ++i) {
+    dblocks[i] = src->dblocks[i];
+    share_dedup_block(dblocks[i]);
+  }
+
+  clear_entry(dst);
+  pool_entry_data(dst);
+  dst->dblocks = dblocks;
+  dst->size = src->size;
+  mark_dirty(dst, 0, dst->size);
+  return 0;
+}
+#endif
+
+static int copy_entry_range(struct Entry *dst, size_t dst_offset, struct Entry *src, size_t src_offset, size_t count, size_t *copied_ref) {
+/* Copies up to count bytes from src_offset of the regular file src to dst_offset of the
+ * regular file dst, with one copy from entry to entry and none at all if the whole of a
+ * deduplicated file replaces the whole of another. Ranges within the same file must not
+ * overlap. *copied_ref is set to the number of bytes copied, which is short at the end
+ * of src.
+ */
+  if (src_offset >= src->size) {
+    *copied_ref = 0;
+    return 0;
+  }
+  if (count > src->size - src_offset)
+    count = src->size - src_offset;
+
+#ifndef VRAMFS_PROFILE_BASIC
+  // A whole-file copy shares the blocks of a deduplicated file, deduplicating it if enabled
+  if (dst != src && !src_offset && !dst_offset && count == src->size && dst->size <= count) {
+    if (!src->dblocks && !src->zdata && __vramfs_dedup_enabled)
+      dedup_entry(src);
+    if (src->dblocks && !share_entry(dst, src)) {
+      *copied_ref = count;
+      return 0;
+    }
+  }
+#endif
+
+  size_t dirty;
+  int errcode = prepare_write(dst, dst_offset, count, &dirty);
+  if (errcode)
+    return errcode;
+
+  errcode = entry_copy_out(src, src_offset, dst->data + dst_offset, count);
+  mark_dirty(dst, dirty, dst_offset + count);
+  if (errcode)
+    return errcode;
+
+  *copied_ref = count;
+  return 0;
+}
+
+static int seek_entry(struct File *file, off_t offset, int whence, off_t *new_offset_ref) {
+/* Computes the new offset of a regular file. Seeking past the end is allowed, the gap
+ * is zero-filled by the next write.
+ */
+  if ((!file) || (!file->entref) || (!new_offset_ref))
+    return ERR_NULLPTR;
+
+  off_t base;
+  switch (whence) {
+    case SEEK_SET:
+    base = 0;
+    break;
+
+    case SEEK_CUR:
+    base = (off_t)file->offset;
+    break;
+
+    case SEEK_END:
+    base = (off_t)(file->entref)->size;
+    break;
+
+    default:
+    return ERR_INVALID;
+  }
+
+  if (offset < -base)
+    return ERR_INVALID;
+
+  *new_offset_ref = base + offset;
+  return 0;
+}
+
+static int stat_entry(struct Entry *entref, struct stat *buf) {
+/* Fills in buf for a regular file. */
+  if (!entref || !buf)
+    return ERR_NULLPTR;
+
+  memset(buf, 0, sizeof(struct stat));
+  buf->st_mode = S_IFREG | 0666;
+  buf->st_nlink = entref->nlink;
+  buf->st_size = (off_t)entref->size;
+  return 0;
+}
+
+static void fill_zero(void *buf, size_t count) {
+/* Zero-fills buf using 16-byte vector stores for the aligned bulk of the buffer. */
+  typedef unsigned long long v2u64 __attribute__((vector_size(16)));
+
+  unsigned char *cbuf = (unsigned char *)buf;
+
+  while (count && ((uintptr_t)cbuf & (sizeof(v2u64) - 1))) {
+    *cbuf++ = 0;
+    --count;
+  }
+
+  v2u64 *vbuf = (v2u64 *)cbuf;
+  for (; count >= sizeof(v2u64); count -= sizeof(v2u64))
+    *vbuf++ = (v2u64){0, 0};
+
+  cbuf = (unsigned char *)vbuf;
+  while (count--)
+    *cbuf++ = 0;
+}
+
+static int read_devzero(struct File *file, void *buf, size_t count, ssize_t *new_count_ref) {
+/* Reading from /dev/zero yields as many zero bytes as requested. */
+  if (!buf)
+    return ERR_NULLPTR;
+
+  fill_zero(buf, count);
+  *new_count_ref = count;
+  return 0;
+}
+
+/* /dev/urandom is a counter-based generator: every read reserves a range of counter
+ * values and hashes them with the SplitMix64 finalizer, mixed with %clock64. This is
+ * cheap and safe to call concurrently, but obviously not cryptographically secure.
+ */
+static unsigned long long urandom_counter;
+
+static unsigned long long splitmix64(unsigned long long x) {
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+static int read_devurandom(struct File *file, void *buf, size_t count, ssize_t *new_count_ref) {
+  if (!buf)
+    return ERR_NULLPTR;
+
+  size_t words = (count + sizeof(unsigned long long) - 1) / sizeof(unsigned long long);
+  unsigned long long ctr = __atomic_fetch_add(&urandom_counter, words, __ATOMIC_RELAXED);
+
+  unsigned long long key = splitmix64(read_clock64());
+
+  unsigned char *cbuf = (unsigned char *)buf;
+  for (size_t i = 0; i < count; i += sizeof(unsigned long long)) {
+    unsigned long long word = splitmix64(ctr++ ^ key);
+    size_t n = count - i < sizeof(word) ? count - i : sizeof(word);
+    memcpy(cbuf + i, &word, n);
+  }
+
+  *new_count_ref = count;
+  return 0;
+}
+
+static int read_eof(struct File *file, void *buf, size_t count, ssize_t *new_count_ref) {
+/* Always at end of file: used for /dev/null, and for stdin unless the host feeds it. */
+  *new_count_ref = 0;
+  return 0;
+}
+
+static int read_stdin(struct File *file, void *buf, size_t count, ssize_t *new_count_ref) {
+/* Takes up to count bytes out of the ring buffer the host feeds stdin through, see stdin.c. */
+  if (!buf && count)
+    return ERR_NULLPTR;
+
+  ssize_t n = __nvptx_stdin_read(buf, count);
+  if (n < 0)
+    return ERR_WOULD_BLOCK;
+  *new_count_ref = n;
+  return 0;
+}
+
+static int write_discard(struct File *file, const void *buf, size_t count, ssize_t *new_count_ref) {
+/* Accepts and discards all data. */
+  *new_count_ref = count;
+  return 0;
+}
+
+static void emit_stdio(const void *buf, size_t count, ssize_t *new_count_ref) {
+/* Emits count bytes of buf through putchar, which assembles the bytes into lines and
+ * emits each line as a single printf record.
+ */
+  const unsigned char *cbuf = (const unsigned char *)buf;
+  for (size_t i = 0; i < count; ++i) {
+    if (putchar (cbuf[i]) < 0)
+      break;
+    ++*new_count_ref;
+  }
+}
+
+static int emit_stdio_record(const char *data, size_t len) {
+/* Prints len bytes of data, which hold no NUL byte, as one %s record. The record is
+ * assembled in a free one of the stdio_records buffers, or waits for the next one in
+ * turn if all are taken. Returns what printf() does.
+ */
+  unsigned int next = __atomic_fetch_add(&stdio_records_next, 1, __ATOMIC_RELAXED);
+  int slot = -1;
+  for (int i = 0; i < STDIO_RECORD_SLOTS && slot < 0; ++i) {
+    if (spin_trylock(&stdio_records[(next + i) % STDIO_RECORD_SLOTS].lock))
+      slot = (next + i) % STDIO_RECORD_SLOTS;
+  }
+  if (slot < 0) {
+    slot = next % STDIO_RECORD_SLOTS;
+    spin_lock(&stdio_records[slot].lock);
+  }
+
+  memcpy(stdio_records[slot].data, data, len);
+  stdio_records[slot].data[len] = '\0';
+  int res = printf("%s", stdio_records[slot].data);
+  spin_unlock(&stdio_records[slot].lock);
+  return res;
+}
+
+static void emit_stdio_records(const void *buf, size_t count, ssize_t *new_count_ref) {
+/* Emits count bytes of buf as printf records of up to STDIO_RECORD bytes, rather than
+ * assembling lines byte by byte. Binary logging keeps only NVPTX_LOG_MAX_STRING bytes of
+ * a %s, so the records are cut to that while it's on. A NUL byte would end the %s, so
+ * each one goes out as a %c record of its own.
+ */
+  const char *cbuf = (const char *)buf;
+  size_t max = STDIO_RECORD;
+  if (__nvptx_log.enabled && max > NVPTX_LOG_MAX_STRING)
+    max = NVPTX_LOG_MAX_STRING;
+
+  while (count) {
+    size_t len = count < max ? count : max;
+    const char *nul = memchr(cbuf, '\0', len);
+    if (nul)
+      len = nul - cbuf;
+
+    if (len) {
+      if (emit_stdio_record(cbuf, len) < 0)
+        break;
+    } else {
+      if (printf("%c", '\0') < 0)
+        break;
+      len = 1;
+    }
+
+    cbuf += len;
+    count -= len;
+    *new_count_ref += len;
+  }
+}
+
+static int write_stdio(struct File *file, const void *buf, size_t count, ssize_t *new_count_ref) {
+/* Writing to STDOUT or STDERR invokes printf, unless the host has asked for the streams
+ * to be captured before launching the kernel.
+ */
+  if (!buf)
+    return ERR_NULLPTR;
+
+  if (__vramfs_capture.enabled && !__vramfs_capture_stdio(1))
+    return (file->entref)->ops->write(file, buf, count, new_count_ref);
+
+  emit_stdio(buf, count, new_count_ref);
+  return 0;
+}
+
+static int write_capture(struct File *file, const void *buf, size_t count, ssize_t *new_count_ref) {
+/* Appends to a captured stream. Space is reserved atomically, so concurrent writers never
+ * overlap. Whatever doesn't fit into the capture buffer goes out through printf instead.
+ */
+  if ((!file) || (!file->entref) || (!buf))
+    return ERR_NULLPTR;
+
+  struct Entry *entref = file->entref;
+  int stream = entref->data == __vramfs_capture.data[1];
+
+  unsigned long long offset = __atomic_fetch_add(&__vramfs_capture.size[stream], count, __ATOMIC_RELAXED);
+  size_t kept = 0;
+
+  if (offset < VRAMFS_CAPTURE_SIZE) {
+    kept = VRAMFS_CAPTURE_SIZE - offset < count ? VRAMFS_CAPTURE_SIZE - offset : count;
+    memcpy(entref->data + offset, buf, kept);
+  }
+
+  if (offset + count >= VRAMFS_CAPTURE_WATERMARK)
+    __vramfs_capture.ready = 1;
+
+  unsigned long long size = __atomic_load_n(&__vramfs_capture.size[stream], __ATOMIC_RELAXED);
+  entref->size = size < VRAMFS_CAPTURE_SIZE ? size : VRAMFS_CAPTURE_SIZE;
+
+  if (kept < count) {
+    __atomic_fetch_add(&__vramfs_capture.overflow[stream], count - kept, __ATOMIC_RELAXED);
+    ssize_t spilled = 0;
+    emit_stdio((const char *)buf + kept, count - kept, &spilled);
+  }
+
+  *new_count_ref = count;
+  return 0;
+}
+
+static int seek_device(struct File *file, off_t offset, int whence, off_t *new_offset_ref) {
+/* Devices have no position, so seeking always succeeds and yields offset 0. */
+  *new_offset_ref = 0;
+  return 0;
+}
+
+static int seek_stream(struct File *file, off_t offset, int whence, off_t *new_offset_ref) {
+/* The standard I/O streams behave like pipes. */
+  return ERR_ILLEGAL_SEEK;
+}
+
+static int stat_chardev(struct Entry *entref, struct stat *buf) {
+/* Fills in buf for devices and standard I/O streams. */
+  if (!entref || !buf)
+    return ERR_NULLPTR;
+
+  memset(buf, 0, sizeof(struct stat));
+  buf->st_mode = S_IFCHR | 0666;
+  buf->st_nlink = 1;
+  return 0;
+}
+
+static int read_dir(struct File *file, void *buf, size_t count, ssize_t *new_count_ref) {
+/* open() refuses directories, so this is never reached through a file descriptor. */
+  return ERR_IS_DIR;
+}
+
+static int write_dir(struct File *file, const void *buf, size_t count, ssize_t *new_count_ref) {
+  return ERR_IS_DIR;
+}
+
+static int stat_dir(struct Entry *entref, struct stat *buf) {
+/* Fills in buf for a directory. */
+  if (!entref || !buf)
+    return ERR_NULLPTR;
+
+  memset(buf, 0, sizeof(struct stat));
+  buf->st_mode = S_IFDIR | 0777;
+  buf->st_nlink = 2;
+  return 0;
+}
+
+static ino_t entry_ino(const struct Entry *entref) {
+/* Inode numbers: 1 for the root directory, then /dev and the devices, then the vramfs slots. */
+  if (entref == &root_dir)
+    return 1;
+  if (entref >= dev_entries && entref < dev_entries + NDEV_ENTRIES)
+    return 2 + (entref - dev_entries);
+  return 2 + NDEV_ENTRIES + (entref - vramfs);
+}
+
+static int path_errno(int errcode) {
+/* Maps the errors of resolving, creating and removing entries by path to errno values. */
+  switch (errcode) {
+    case ERR_NULLPTR: return EFAULT;
+    case ERR_ENTRY_NOT_FOUND: return ENOENT;
+    case ERR_ENTRIES_EXHAUSTED: return ENOSPC;
+    case ERR_NOT_DIR: return ENOTDIR;
+    case ERR_IS_DIR: return EISDIR;
+    case ERR_NAME_TOO_LONG: return ENAMETOOLONG;
+    case ERR_EXISTS: return EEXIST;
+    case ERR_NOT_EMPTY: return ENOTEMPTY;
+    case ERR_BUSY: return EBUSY;
+    default: return EINVAL;
+  }
+}
+/*****************************************************************************************************/
+
+
+/******************************************* SYSTEM CALLS *******************************************/
+int
+close(int fd) {
+
+  // No illegal or closed file descriptors allowed
+  struct File *file = fd_file(fd);
+  if (!file) {
+    errno = EBADF;
+    return -1;
+  }
+
+  // Offset should be reset for all open files
+  file->offset = 0;
+
+  // For all default open files which won't actually be closed
+  if (fd < UNRESERVED_FD_START)
+    return 0;
+
+  // Other files are actually closed, unless another thread of the team beat us to it
+  struct Entry *entref = __atomic_exchange_n(&file->entref, NULL, __ATOMIC_ACQ_REL);
+  if (!entref) {
+    errno = EBADF;
+    return -1;
+  }
+  unsigned int nopen = __atomic_sub_fetch(&entref->nopen, 1, __ATOMIC_ACQ_REL);
+
+  // A file that lost its last name while it was open goes now
+  if (entref->type == ENT_TYPE_REGULAR && !nopen && !__atomic_load_n(&entref->nlink, __ATOMIC_ACQUIRE)) {
+    release_if_unused(entref);
+    return 0;
+  }
+
+  /* Files are deduplicated, or large ones compressed, once closed if enabled (failure is
+   * not an error). Another thread may open the file again in the meantime.
+   */
+  int dedup = __vramfs_dedup_enabled;
+  int compress = __vramfs_compress_threshold && entref->size >= __vramfs_compress_threshold;
+  if (entref->type == ENT_TYPE_REGULAR && !nopen && (dedup || compress)) {
+    struct Shard *shard = slot_shard(entref);
+    spin_lock(&shard->lock);
+    if (dedup)
+      dedup_closed_entry(entref);
+    else
+      compress_closed_entry(entref);
+    spin_unlock(&shard->lock);
+  }
+  return 0;
+}
+
+
+int
+fstat (int fd, struct stat *buf) {
+
+  // No illegal or closed file descriptors allowed
+  struct File *file = fd_file(fd);
+  if (!file) {
+    errno = EBADF;
+    return -1;
+  }
+
+  struct Entry *entref = file->entref;
+  if (entref->ops->stat(entref, buf) == ERR_NULLPTR) {
+    errno = EFAULT;
+    return -1;
+  }
+  return 0;
+}
+
+
+int
+getpid (void) {
+  return 0;
+}
+
+
+int
+isatty (int fd) {
+  return fd == 1;
+}
+
+
+int
+kill (int pid, int sig) {
+  errno = ESRCH;
+  return -1;
+}
+
+
+off_t
+lseek(int fd, off_t offset, int whence) {
+
+  // No illegal or closed file descriptors allowed
+  struct File *file = fd_file(fd);
+  if (!file) {
+    errno = EBADF;
+    return -1;
+  }
+  off_t new_offset;
+
+  int errcode = (file->entref)->ops->seek(file, offset, whence, &new_offset);
+  if (errcode == ERR_ILLEGAL_SEEK) {
+    errno = ESPIPE;
+    return -1;
+  }
+  if (errcode == ERR_INVALID) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  file->offset = (size_t)new_offset;
+  return new_offset;
+}
+
+
+static int
+open_in_table (struct FdTable *table, const char *pathname, int flags) {
+
+  int fd;
+  for (fd = UNRESERVED_FD_START; fd < MAX_FOPEN; ++fd) {
+
+    // A closed slot (entref = NULL) or one left over from an older epoch is free
+    struct File *file = table->files + fd - UNRESERVED_FD_START;
+    if (!file->entref || file->epoch != fs_epoch)
+      break;
+  }
+
+  if (fd == MAX_FOPEN) {
+    errno = ENFILE;
+    return -1;
+  }
+
+  struct File *file = table->files + fd - UNRESERVED_FD_START;
+
+  struct Entry *entref;
+  int clear = 0;
+  int errcode = find_entry(pathname, &entref);
+
+  if (errcode && errcode != ERR_ENTRY_NOT_FOUND) {
+    errno = path_errno(errcode);
+    return -1;
+  }
+
+  // Directories are read with opendir() & readdir()
+  if (!errcode && entref->type == ENT_TYPE_DIRECTORY) {
+    errno = EISDIR;
+    return -1;
+  }
+
+  // A hard link opens the file it refers to
+  if (!errcode)
+    entref = entry_inode(entref);
+  
+  switch (flags) {
+    case MODE_R:
+    if (errcode == ERR_ENTRY_NOT_FOUND) {
+      errno = ENOENT;
+      return -1;
+    }
+    file->offset = 0;
+    file->mode = MODE_R;
+    break;
+
+    case MODE_W:
+    if (errcode == ERR_ENTRY_NOT_FOUND) {
+      errcode = init_entry(pathname, &entref);
+      if (errcode) {
+        errno = path_errno(errcode);
+        return -1;
+      }
+    }
+    else {
+      clear = 1;
+    }
+    file->offset = 0;
+    file->mode = MODE_W;
+    break;
+
+    case MODE_A:
+    if (errcode == ERR_ENTRY_NOT_FOUND) {
+      errcode = init_entry(pathname, &entref);
+      if (errcode) {
+        errno = path_errno(errcode);
+        return -1;
+      }
+    }
+    file->offset = entref->size;
+    file->mode = MODE_A;
+    break;
+
+    case MODE_R_PLUS:
+    if (errcode == ERR_ENTRY_NOT_FOUND) {
+      errno = ENOENT;
+      return -1;
+    }
+    file->offset = 0;
+    file->mode = MODE_R_PLUS;
+    break;
+
+    case MODE_W_PLUS:
+    if (errcode == ERR_ENTRY_NOT_FOUND) {
+      errcode = init_entry(pathname, &entref);
+      if (errcode) {
+        errno = path_errno(errcode);
+        return -1;
+      }
+    }
+    else {
+      clear = 1;
+    }
+    file->offset = 0;
+    file->mode = MODE_W_PLUS;
+    break;
+
+    case MODE_A_PLUS:
+    if (errcode == ERR_ENTRY_NOT_FOUND) {
+      errcode = init_entry(pathname, &entref);
+      if (errcode) {
+        errno = path_errno(errcode);
+        return -1;
+      }
+    }
+    file->offset = entref->size;
+    file->mode = MODE_A_PLUS;
+    break;
+
+    case MODE_RW_TRUNC:
     if (errcode == ERR_ENTRY_NOT_FOUND) {
       errno = ENOENT;
       return -1;
     }
-    open_files[fd].offset = 0;
-    open_files[fd].mode = MODE_R;
-    open_files[fd].entref = entref;
+    clear = 1;
+    file->offset = 0;
+    file->mode = MODE_RW_TRUNC;
     break;
 
-    case MODE_W:
-    if (errcode == ERR_ENTRY_NOT_FOUND) {
-      errcode = init_entry(pathname, &entref);
-      if (errcode == ERR_ENTRIES_EXHAUSTED) {
-        errno = ENOSPC;
-        return -1;
-      }
-    }
-    else {
-      clear_entry(entref);
-      /* We are not checking for the error code in
-       * clear_entry() here because entref
-       * in this case is guaranteed to be valid.
-       * This function returns only ERR_NULLPTR
-       * if entref is NULL, otherwise 0.
-       */
-    }
-    open_files[fd].offset = 0;
-    open_files[fd].mode = MODE_W;
-    open_files[fd].entref = entref;
-    break;
+    default:
+    errno = ENOTSUP;
+    return -1;
+  }
+
+  /* Holding the file open keeps unlink() from freeing it under us; it may have lost its
+   * last name since it was looked up though. Do not allow opening a regular file that is
+   * already open (set EACCES).
+   */
+  if (entref->type != ENT_TYPE_REGULAR)
+    __atomic_add_fetch(&entref->nopen, 1, __ATOMIC_ACQ_REL);
+  else if ((errcode = pin_inode(entref, &entref->nopen))) {
+    errno = errcode == ERR_BUSY ? EACCES : ENOENT;
+    return -1;
+  }
+
+  /* We are not checking for the error code in clear_entry() here because entref
+   * in this case is guaranteed to be valid. This function returns only ERR_NULLPTR
+   * if entref is NULL, otherwise 0.
+   */
+  if (clear)
+    clear_entry(entref);
+
+  // Publish the slot last, it's free until entref is set
+  file->epoch = fs_epoch;
+  __atomic_store_n(&file->entref, entref, __ATOMIC_RELEASE);
+  return fd;
+}
+
+int
+open (const char *pathname, int flags, ...) {
+
+  struct FdTable *table = fd_table();
+  spin_lock(&table->lock);
+  int fd = open_in_table(table, pathname, flags);
+  spin_unlock(&table->lock);
+  return fd;
+}
+
+ssize_t
+read(int fd, void *buf, size_t count) {
+
+  // No illegal or closed file descriptors allowed
+  struct File *file = fd_file(fd);
+  if (!file) {
+    errno = EBADF;
+    return -1;
+  }
+
+  // Error if read attempt from a file opened with O_WRONLY
+  if (file->mode == MODE_W || file->mode == MODE_A) {
+    errno = EBADF;
+    return -1;
+  }
+  
+  ssize_t new_count = 0;
+
+  int errcode = (file->entref)->ops->read(file, buf, count, &new_count);
+  if (errcode == ERR_NULLPTR) {
+    errno = EFAULT;
+    return -1;
+  }
+  if (errcode == ERR_NO_SPACE) {
+    errno = ENOMEM;
+    return -1;
+  }
+  if (errcode == ERR_INVALID) {
+    errno = EIO;
+    return -1;
+  }
+  if (errcode == ERR_WOULD_BLOCK) {
+    errno = EAGAIN;
+    return -1;
+  }
+
+  file->offset += new_count;
+  return new_count;
+}
+
+static int write_combined(void *ctx, const void *buf, size_t count, ssize_t *new_count_ref) {
+/* Writes the combined buffer of the lanes of a warp that write to the fd at ctx
+ * together; see warpwrite.c. Any error has the lanes write on their own.
+ */
+  struct File *file = fd_file(*(int *)ctx);
+  if (!file || file->mode == MODE_R)
+    return ERR_INVALID;
+
+  int errcode = (file->entref)->ops->write(file, buf, count, new_count_ref);
+  if (!errcode)
+    file->offset += *new_count_ref;
+  return errcode;
+}
+
+ssize_t
+write (int fd, const void *buf, size_t count) {
+
+  ssize_t new_count = 0;
+
+  // Lanes of a warp that write to the same fd together do so with a single write
+  if (!__nvptx_warp_write(fd, buf, count, write_combined, &fd, &new_count))
+    return new_count;
+
+  // No illegal or closed file descriptors allowed
+  struct File *file = fd_file(fd);
+  if (!file) {
+    errno = EBADF;
+    return -1;
+  }
+
+  // Error if write attempt to a file opened with O_RDONLY
+  if (file->mode == MODE_R) {
+    errno = EBADF;
+    return -1;
+  }
+
+  int errcode = (file->entref)->ops->write(file, buf, count, &new_count);
+  if (errcode == ERR_NO_SPACE) {
+    errno = ENOSPC;
+    return -1;
+  }
+  if (errcode == ERR_NULLPTR) {
+    errno = EFAULT;
+    return -1;
+  }
+
+  file->offset += new_count;
+  return new_count;
+}
+
+int
+stat (const char *file, struct stat *pstat) {
+
+  struct Entry *entref;
+  int errcode = find_entry(file, &entref);
+  if (errcode) {
+    errno = path_errno(errcode);
+    return -1;
+  }
+  entref = entry_inode(entref);
+  if (entref->ops->stat(entref, pstat) == ERR_NULLPTR) {
+    errno = EFAULT;
+    return -1;
+  }
+  return 0;
+}
+
+void
+sync (void) {
+}
+
+int
+unlink (const char *pathname) {
+
+  struct Entry *entref;
+  int errcode = find_entry(pathname, &entref);
+  if (!errcode && entref->type == ENT_TYPE_DIRECTORY)
+    errcode = ERR_IS_DIR;
+  if (errcode) {
+    errno = path_errno(errcode);
+    return -1;
+  }
+
+  // Devices and streams stay
+  if (entref->type != ENT_TYPE_REGULAR) {
+    errno = EPERM;
+    return -1;
+  }
+
+  errcode = remove_name(entref);
+  if (errcode) {
+    errno = path_errno(errcode);
+    return -1;
+  }
+  return 0;
+}
+
+int
+link (const char *oldpath, const char *newpath) {
+
+  struct Entry *entref;
+  int errcode = find_entry(oldpath, &entref);
+  if (errcode) {
+    errno = path_errno(errcode);
+    return -1;
+  }
+
+  // Only regular files can have more than one name
+  if (entref->type != ENT_TYPE_REGULAR) {
+    errno = EPERM;
+    return -1;
+  }
+
+  struct Entry *parent, *target;
+  const char *base;
+  size_t base_len;
+  errcode = resolve_path(newpath, &parent, &base, &base_len, &target);
+  if (!errcode)
+    errcode = ERR_EXISTS;
+  else if (errcode == ERR_ENTRY_NOT_FOUND && parent) {
+    struct Entry *inode = entry_inode(entref);
+    errcode = pin_inode(inode, &inode->nlink);
+    if (!errcode) {
+      errcode = alloc_entry(parent, base, base_len, ENT_TYPE_REGULAR, NULL, NULL, inode, &target);
+      if (errcode && !__atomic_sub_fetch(&inode->nlink, 1, __ATOMIC_ACQ_REL))
+        release_if_unused(inode);
+    }
+  }
+
+  if (errcode) {
+    errno = path_errno(errcode);
+    return -1;
+  }
+  return 0;
+}
+
+int
+rename (const char *oldpath, const char *newpath) {
+
+  struct Entry *entref;
+  int errcode = find_entry(oldpath, &entref);
+  if (errcode) {
+    errno = path_errno(errcode);
+    return -1;
+  }
+
+  // The root directory, /dev, the devices and captured streams stay where they are
+  if (entref->type != ENT_TYPE_REGULAR && entref->type != ENT_TYPE_DIRECTORY) {
+    errno = EBUSY;
+    return -1;
+  }
+  if (entref == &root_dir || entref == &dev_entries[0]) {
+    errno = EBUSY;
+    return -1;
+  }
+
+  struct Entry *parent, *target;
+  const char *base;
+  size_t base_len;
+  errcode = resolve_path(newpath, &parent, &base, &base_len, &target);
+  if (errcode && (errcode != ERR_ENTRY_NOT_FOUND || !parent)) {
+    errno = path_errno(errcode);
+    return -1;
+  }
+
+  // A directory can't move into itself
+  if (entref->type == ENT_TYPE_DIRECTORY) {
+    for (struct Entry *dir = parent; dir && dir != &root_dir; dir = dir->parent) {
+      if (dir == entref) {
+        errno = EINVAL;
+        return -1;
+      }
+    }
+  }
+
+  /* An existing entry of the new name is replaced, if it's of the same kind. This is
+   * not atomic: another thread may briefly see neither name, or create the new name
+   * in between, which fails the rename with EEXIST.
+   */
+  if (!errcode) {
+    if (target == entref || entry_inode(target) == entry_inode(entref))
+      return 0;
+
+    if (target->type == ENT_TYPE_DIRECTORY)
+      errcode = entref->type == ENT_TYPE_DIRECTORY ? remove_dir(target) : ERR_IS_DIR;
+    else if (entref->type == ENT_TYPE_DIRECTORY)
+      errcode = ERR_NOT_DIR;
+    else if (target->type == ENT_TYPE_REGULAR)
+      errcode = remove_name(target);
+    else
+      errcode = ERR_BUSY;
+
+    // It doesn't matter who removed it
+    if (errcode && errcode != ERR_ENTRY_NOT_FOUND) {
+      errno = path_errno(errcode);
+      return -1;
+    }
+  }
+
+  errcode = move_entry(entref, parent, base, base_len);
+  if (errcode) {
+    errno = path_errno(errcode);
+    return -1;
+  }
+  return 0;
+}
+
+int
+ftruncate (int fd, off_t length) {
+
+  // No illegal or closed file descriptors allowed
+  struct File *file = fd_file(fd);
+  if (!file) {
+    errno = EBADF;
+    return -1;
+  }
+
+  // Only regular files opened for writing can be resized
+  if (length < 0 || file->mode == MODE_R || file->entref->type != ENT_TYPE_REGULAR) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (resize_entry(file->entref, (size_t)length)) {
+    errno = ENOSPC;
+    return -1;
+  }
+  return 0;
+}
+
+int
+truncate (const char *pathname, off_t length) {
+
+  struct Entry *entref;
+  int errcode = find_entry(pathname, &entref);
+  if (!errcode && entref->type == ENT_TYPE_DIRECTORY)
+    errcode = ERR_IS_DIR;
+  if (errcode) {
+    errno = path_errno(errcode);
+    return -1;
+  }
+
+  if (length < 0 || entref->type != ENT_TYPE_REGULAR) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if (resize_entry(entry_inode(entref), (size_t)length)) {
+    errno = ENOSPC;
+    return -1;
+  }
+  return 0;
+}
+
+int
+posix_fallocate (int fd, off_t offset, off_t len) {
 
-    case MODE_A:
-    if (errcode == ERR_ENTRY_NOT_FOUND) {
-      errcode = init_entry(pathname, &entref);
-      if (errcode == ERR_ENTRIES_EXHAUSTED) {
-        errno = ENOSPC;
-        return -1;
-      }
-    }
-    open_files[fd].offset = entref->size;
-    open_files[fd].mode = MODE_A;
-    open_files[fd].entref = entref;
-    break;
+  // Errors are returned rather than set in errno
+  if (offset < 0 || len <= 0)
+    return EINVAL;
 
-    case MODE_R_PLUS:
-    if (errcode == ERR_ENTRY_NOT_FOUND) {
-      errno = ENOENT;
-      return -1;
-    }
-    open_files[fd].offset = 0;
-    open_files[fd].mode = MODE_R_PLUS;
-    open_files[fd].entref = entref;
-    break;
+  struct File *file = fd_file(fd);
+  if (!file || file->mode == MODE_R)
+    return EBADF;
 
-    case MODE_W_PLUS:
-    if (errcode == ERR_ENTRY_NOT_FOUND) {
-      errcode = init_entry(pathname, &entref);
-      if (errcode == ERR_ENTRIES_EXHAUSTED) {
-        errno = ENOSPC;
-        return -1;
-      }
-    }
-    else {
-      clear_entry(entref);
-    }
-    open_files[fd].offset = 0;
-    open_files[fd].mode = MODE_W_PLUS;
-    open_files[fd].entref = entref;
-    break;
+  struct Entry *entref = file->entref;
+  if (entref->type != ENT_TYPE_REGULAR)
+    return ENODEV;
 
-    case MODE_A_PLUS:
-    if (errcode == ERR_ENTRY_NOT_FOUND) {
-      errcode = init_entry(pathname, &entref);
-      if (errcode == ERR_ENTRIES_EXHAUSTED) {
-        errno = ENOSPC;
-        return -1;
-      }
-    }
-    open_files[fd].offset = entref->size;
-    open_files[fd].mode = MODE_A_PLUS;
-    open_files[fd].entref = entref;
-    break;
+  if (len > (off_t)(~(size_t)0 >> 1) - offset)
+    return EFBIG;
 
-    case MODE_RW_TRUNC:
-    if (errcode == ERR_ENTRY_NOT_FOUND) {
-      errno = ENOENT;
-      return -1;
-    }
-    clear_entry(entref);
-    open_files[fd].offset = 0;
-    open_files[fd].mode = MODE_RW_TRUNC;
-    open_files[fd].entref = entref;
-    break;
+  /* The file is extended to cover the range, as POSIX wants, with its buffer sized for
+   * the range up front so that writing it in pieces never reallocates.
+   */
+  size_t end = (size_t)(offset + len);
+  if (end > entref->size && resize_entry(entref, end))
+    return ENOSPC;
+  return 0;
+}
 
-    default:
-    errno = ENOTSUP;
-    return -1;
+static int send_chunk(struct File *out, const char *buf, size_t count, ssize_t *new_count_ref) {
+/* Writes a run of file data to a file that isn't regular. The standard streams take
+ * it in whole printf records, unless they are captured.
+ */
+  struct Entry *entref = out->entref;
+
+  /* Turning capture on rebinds the standard streams' files to the capture entries, so
+   * out's entry has to be read again afterwards, as in write_stdio().
+   */
+  if (entref->ops == &stdout_ops && __vramfs_capture.enabled) {
+    if (!__vramfs_capture_stdio(1))
+      entref = out->entref;  // Now the capture entry, not stdout's
   }
 
-  return fd;
+  if (entref->ops == &stdout_ops) {
+    emit_stdio_records(buf, count, new_count_ref);
+    return 0;
+  }
+  return entref->ops->write(out, buf, count, new_count_ref);
+}
+
+static int send_entry_range(struct File *out, struct Entry *src, size_t offset, size_t count, size_t *sent_ref) {
+/* Writes up to count bytes from the given offset of the regular file src to out, which
+ * isn't a regular file, straight from the file's data. *sent_ref is set to the number of
+ * bytes written, which is short at the end of src or if out takes less.
+ */
+  *sent_ref = 0;
+  while (count && offset < src->size) {
+    const char *chunk;
+    size_t n;
+    int errcode = entry_chunk(src, offset, &chunk, &n);
+    if (errcode)
+      return errcode;
+
+    if (n > count)
+      n = count;
+    ssize_t written = 0;
+    errcode = send_chunk(out, chunk, n, &written);
+    if (errcode)
+      return errcode;
+
+    *sent_ref += written;
+    if ((size_t)written < n)
+      break;
+    offset += n;
+    count -= n;
+  }
+  return 0;
+}
+
+static int copy_overlaps(struct Entry *src, size_t src_offset, struct Entry *dst, size_t dst_offset, size_t count) {
+/* Tells whether copying up to count bytes from src_offset of src to dst_offset of dst
+ * reads bytes it writes, which can only happen within the same file.
+ */
+  if (src != dst || src_offset >= src->size)
+    return 0;
+  if (count > src->size - src_offset)
+    count = src->size - src_offset;
+  return src_offset < dst_offset + count && dst_offset < src_offset + count;
+}
+
+static int copy_errno(int errcode) {
+/* Maps the errors of copying between files to errno values. */
+  switch (errcode) {
+    case ERR_NULLPTR: return EFAULT;
+    case ERR_NO_SPACE: return ENOSPC;
+    default: return EIO;
+  }
 }
 
 ssize_t
-read(int fd, void *buf, size_t count) {
+copy_file_range (int fd_in, off_t *off_in, int fd_out, off_t *off_out, size_t len, unsigned int flags) {
 
-  // No illegal file descriptors allowed
-  if (fd < 0 || fd > MAX_FOPEN - 1) {
+  struct File *in = fd_file(fd_in);
+  struct File *out = fd_file(fd_out);
+  if (!in || !out || in->mode == MODE_W || in->mode == MODE_A || out->mode == MODE_R
+      || (out->mode & O_APPEND)) {
     errno = EBADF;
     return -1;
   }
 
-  struct File *file = open_files + fd;
+  // Both ends have to be regular files
+  struct Entry *src = in->entref;
+  struct Entry *dst = out->entref;
+  if (flags || src->type != ENT_TYPE_REGULAR || dst->type != ENT_TYPE_REGULAR
+      || (off_in && *off_in < 0) || (off_out && *off_out < 0)) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  size_t src_offset = off_in ? (size_t)*off_in : in->offset;
+  size_t dst_offset = off_out ? (size_t)*off_out : out->offset;
 
-  // Error if read attempt from a file opened with O_WRONLY
-  if (file->mode == MODE_W || file->mode == MODE_A) {
-    errno = EBADF;
+  // Ranges within the same file must not overlap
+  if (copy_overlaps(src, src_offset, dst, dst_offset, len)) {
+    errno = EINVAL;
     return -1;
   }
-  
-  ssize_t new_count = 0;
 
-  // fd is valid file descriptor so no need to check errcode
-  read_entry_data(file, buf, count, &new_count);
-  if (errcode == ERR_NULLPTR) {
-    errno = EFAULT;
+  size_t copied;
+  int errcode = copy_entry_range(dst, dst_offset, src, src_offset, len, &copied);
+  if (errcode) {
+    errno = copy_errno(errcode);
     return -1;
   }
 
-  file->offset += new_count;
-  return new_count;
+  if (off_in)
+    *off_in += copied;
+  else
+    in->offset += copied;
+  if (off_out)
+    *off_out += copied;
+  else
+    out->offset += copied;
+  return copied;
 }
 
 ssize_t
-write (int fd, const void *buf, size_t count) {
+sendfile (int out_fd, int in_fd, off_t *offset, size_t count) {
 
-  // No illegal file descriptors allowed
-  if (fd < 0 || fd > MAX_FOPEN - 1) {
+  struct File *in = fd_file(in_fd);
+  struct File *out = fd_file(out_fd);
+  if (!in || !out || in->mode == MODE_W || in->mode == MODE_A || out->mode == MODE_R) {
     errno = EBADF;
     return -1;
   }
 
-  struct File *file = open_files + fd;
+  // Only regular files can be sent
+  struct Entry *src = in->entref;
+  struct Entry *dst = out->entref;
+  if (src->type != ENT_TYPE_REGULAR || (offset && *offset < 0)) {
+    errno = EINVAL;
+    return -1;
+  }
 
-  // Error if write attempt to a file opened with O_RDONLY
-  if (file->mode == MODE_R) {
-    errno = EBADF;
+  size_t src_offset = offset ? (size_t)*offset : in->offset;
+  size_t sent;
+  int errcode;
+
+  if (dst->type == ENT_TYPE_REGULAR) {
+    if (out->mode & O_APPEND)
+      out->offset = dst->size;
+    if (copy_overlaps(src, src_offset, dst, out->offset, count)) {
+      errno = EINVAL;
+      return -1;
+    }
+    errcode = copy_entry_range(dst, out->offset, src, src_offset, count, &sent);
+  }
+  else
+    errcode = send_entry_range(out, src, src_offset, count, &sent);
+
+  if (errcode) {
+    errno = copy_errno(errcode);
     return -1;
   }
 
-  ssize_t new_count = 0;
+  if (offset)
+    *offset += sent;
+  else
+    in->offset += sent;
+  out->offset += sent;
+  return sent;
+}
 
-  int errcode = write_entry_data(file, buf, count, &new_count);
-  if (errcode == ERR_NO_SPACE) {
-    errno = ENOSPC;
+int
+mkdir (const char *pathname, mode_t mode) {
+
+  struct Entry *parent, *entref;
+  const char *base;
+  size_t base_len;
+  int errcode = resolve_path(pathname, &parent, &base, &base_len, &entref);
+
+  if (!errcode)
+    errcode = ERR_EXISTS;
+  else if (errcode == ERR_ENTRY_NOT_FOUND && parent)
+    errcode = alloc_entry(parent, base, base_len, ENT_TYPE_DIRECTORY, NULL, NULL, NULL, &entref);
+
+  if (errcode) {
+    errno = path_errno(errcode);
     return -1;
   }
-  if (errcode == ERR_NULLPTR) {
-    errno = EFAULT;
+  return 0;
+}
+
+int
+rmdir (const char *pathname) {
+
+  struct Entry *entref;
+  int errcode = find_entry(pathname, &entref);
+  if (!errcode && entref->type != ENT_TYPE_DIRECTORY)
+    errcode = ERR_NOT_DIR;
+  if (errcode) {
+    errno = path_errno(errcode);
     return -1;
   }
 
-  file->offset += new_count;
-  return new_count;
+  errcode = remove_dir(entref);
+  if (errcode) {
+    errno = path_errno(errcode);
+    return -1;
+  }
+  return 0;
 }
 
-int
-stat (const char *file, struct stat *pstat) {
-  errno = EACCES;
-  return -1;
+DIR *
+opendir (const char *pathname) {
+
+  struct Entry *entref;
+  int errcode = find_entry(pathname, &entref);
+  if (!errcode && entref->type != ENT_TYPE_DIRECTORY)
+    errcode = ERR_NOT_DIR;
+  if (errcode) {
+    errno = path_errno(errcode);
+    return NULL;
+  }
+
+  DIR *dirp = malloc(sizeof(DIR));
+  if (!dirp) {
+    errno = ENOMEM;
+    return NULL;
+  }
+  dirp->__dir = entref;
+  rewinddir(dirp);
+  return dirp;
+}
+
+struct dirent *
+readdir (DIR *dirp) {
+
+  if (!dirp) {
+    errno = EBADF;
+    return NULL;
+  }
+
+  struct Entry *dir = dirp->__dir;
+  spin_lock(&dir->lock);
+
+  // Skip stale children; an entry that has left the directory ends the listing
+  struct Entry *entref = dir->incarnation == dirp->__incarnation ? dirp->__next : NULL;
+  while (entref && entref->parent == dir && entref->parent_incarnation == dirp->__incarnation && !entry_is_live(entref))
+    entref = entref->next_sibling;
+  if (!entref || entref->parent != dir || entref->parent_incarnation != dirp->__incarnation) {
+    spin_unlock(&dir->lock);
+    dirp->__next = NULL;
+    return NULL;
+  }
+  dirp->__next = entref->next_sibling;
+
+  struct dirent *ent = &dirp->__ent;
+  ent->d_ino = entry_ino(entry_inode(entref));
+  if (entref->type == ENT_TYPE_DIRECTORY)
+    ent->d_type = DT_DIR;
+  else if (entref->type == ENT_TYPE_REGULAR || entref->ops == &capture_ops)
+    ent->d_type = DT_REG;
+  else
+    ent->d_type = DT_CHR;
+  strncpy(ent->d_name, entref->name, sizeof(ent->d_name));
+  spin_unlock(&dir->lock);
+  return ent;
 }
 
 void
-sync (void) {
+rewinddir (DIR *dirp) {
+
+  if (!dirp)
+    return;
+
+  struct Entry *dir = dirp->__dir;
+  spin_lock(&dir->lock);
+  dirp->__next = dir->children;
+  dirp->__incarnation = dir->incarnation;
+  spin_unlock(&dir->lock);
 }
 
 int
-unlink (const char *pathname) {
-  return -1;
+closedir (DIR *dirp) {
+
+  if (!dirp) {
+    errno = EBADF;
+    return -1;
+  }
+  free(dirp);
+  return 0;
+}
+
+/****************************************************************************************************/
+
+
+/**************************************** VRAMFS EXTENSIONS *****************************************/
+int
+__vramfs_capture_stdio (int enable) {
+
+  init_namespace();
+  spin_lock(&capture_lock);
+  if (!enable) {
+    __vramfs_capture.enabled = 0;
+    stdio_files[1].entref = &stdio_entries[1];
+    stdio_files[2].entref = &stdio_entries[2];
+    spin_unlock(&capture_lock);
+    return 0;
+  }
+
+  for (int stream = 0; stream < 2; ++stream) {
+    /* The entry is created with its operations and data in place, so a thread that
+     * finds it, or loses the race to create it, never sees a half-made regular file.
+     */
+    struct Entry *parent, *entref;
+    const char *base;
+    size_t base_len;
+    int errcode = resolve_path(capture_names[stream], &parent, &base, &base_len, &entref);
+    if (!errcode)
+      errcode = ERR_EXISTS;
+    else if (errcode == ERR_ENTRY_NOT_FOUND && parent)
+      errcode = alloc_entry(parent, base, base_len, ENT_TYPE_STREAM, &capture_ops,
+                            __vramfs_capture.data[stream], NULL, &entref);
+
+    // Anything else by that name, such as a file the program made, is left alone
+    if (errcode == ERR_EXISTS && entref->ops == &capture_ops)
+      errcode = 0;
+    if (errcode) {
+      spin_unlock(&capture_lock);
+      errno = path_errno(errcode);
+      return -1;
+    }
+
+    // The host may have reset size[] since the stream was last bound
+    if (stdio_files[1 + stream].entref != entref) {
+      unsigned long long size = __vramfs_capture.size[stream];
+      entref->size = size < VRAMFS_CAPTURE_SIZE ? size : VRAMFS_CAPTURE_SIZE;
+      stdio_files[1 + stream].entref = entref;
+    }
+  }
+
+  __vramfs_capture.capacity = VRAMFS_CAPTURE_SIZE;
+  __vramfs_capture.watermark = VRAMFS_CAPTURE_WATERMARK;
+  __vramfs_capture.enabled = 1;
+  spin_unlock(&capture_lock);
+  return 0;
+}
+
+
+static size_t export_pad(size_t size) {
+  return (size + 7) & ~(size_t)7;
+}
+
+static size_t entry_path_len(const struct Entry *entref) {
+/* Length of the absolute path of a live entry. */
+  size_t len = 0;
+  for (; entref != &root_dir; entref = entref->parent)
+    len += strlen(entref->name) + 1;
+  return len;
+}
+
+static void entry_path(const struct Entry *entref, char *buf, size_t len) {
+/* Writes the absolute path of a live entry, len bytes as returned by entry_path_len(),
+ * to buf, back to front. No nul is written.
+ */
+  for (; entref != &root_dir; entref = entref->parent) {
+    size_t name_len = strlen(entref->name);
+    len -= name_len;
+    memcpy(buf + len, entref->name, name_len);
+    buf[--len] = '/';
+  }
+}
+
+static void record_removal(const struct Entry *entref) {
+/* Leaves a tombstone for the path of a live entry that is about to lose it. */
+  size_t len = entry_path_len(entref);
+  char path[MAX_PATH];
+  if (len <= MAX_PATH)
+    entry_path(entref, path, len);
+  unsigned long long gen = __atomic_add_fetch(&fs_generation, 1, __ATOMIC_RELAXED);
+
+  spin_lock(&removals.lock);
+  if (len > MAX_PATH) {  // Too long to remember, so it's forgotten right away
+    if (gen > removals.floor)
+      __atomic_store_n(&removals.floor, gen, __ATOMIC_RELAXED);
+    spin_unlock(&removals.lock);
+    return;
+  }
+
+  int slot = 0, found = 0;
+  for (int i = 0; i < TOMBSTONES && !found; ++i) {
+    found = removals.slots[i].gen && removals.slots[i].len == len && !memcmp(removals.slots[i].path, path, len);
+    if (found || removals.slots[i].gen < removals.slots[slot].gen)
+      slot = i;
+  }
+
+  // Otherwise the oldest tombstone gives way
+  if (!found) {
+    if (removals.slots[slot].gen > removals.floor)
+      __atomic_store_n(&removals.floor, removals.slots[slot].gen, __ATOMIC_RELAXED);
+    removals.slots[slot].len = len;
+    memcpy(removals.slots[slot].path, path, len);
+  }
+  removals.slots[slot].gen = gen;
+  spin_unlock(&removals.lock);
+}
+
+static int path_has_prefix(const struct Entry *entref, const char *prefix, size_t prefix_len) {
+/* Whether the absolute path of a live entry starts with prefix, which is taken to be
+ * relative to the root directory if it doesn't start with '/'.
+ */
+  const struct Entry *chain[MAX_FILES];
+  int depth = 0;
+  for (; entref != &root_dir; entref = entref->parent)
+    chain[depth++] = entref;
+
+  int skip_slash = prefix_len && *prefix != '/';
+  while (depth-- && prefix_len) {
+    if (!skip_slash) {
+      if (*prefix != '/')
+        return 0;
+      ++prefix;
+      --prefix_len;
+    }
+    skip_slash = 0;
+
+    size_t name_len = strlen(chain[depth]->name);
+    size_t len = name_len < prefix_len ? name_len : prefix_len;
+    if (strncmp(chain[depth]->name, prefix, len))
+      return 0;
+    prefix += len;
+    prefix_len -= len;
+  }
+  return !prefix_len;
+}
+
+static int export_selected(struct Entry *entref, const char *prefix, size_t prefix_len) {
+/* Regular files and captured streams are exported by each of their names, devices and
+ * directories are not, and neither are files that have lost their last name.
+ */
+  if (!entry_is_live(entref) || !entref->parent || (entref->type != ENT_TYPE_REGULAR && entref->ops != &capture_ops))
+    return 0;
+  return !prefix_len || path_has_prefix(entref, prefix, prefix_len);
+}
+
+ssize_t
+__vramfs_export (void *buf, size_t size, const char *prefix) {
+
+  size_t prefix_len = prefix ? strlen(prefix) : 0;
+  size_t total = sizeof(struct __vramfs_export_header);
+  unsigned int nentries = 0;
+
+  // First pass: work out the size of the blob
+  for (int i = 0; i < MAX_FILES; ++i) {
+    struct Entry *entref = vramfs + i;
+    if (!export_selected(entref, prefix, prefix_len))
+      continue;
+
+    total += sizeof(struct __vramfs_export_entry);
+    total += export_pad(entry_path_len(entref) + 1);
+    total += export_pad(entry_inode(entref)->size);
+    ++nentries;
+  }
+
+  if (!buf || size < total)
+    return total;
+
+  // Second pass: serialize, in the same order
+  char *cbuf = (char *)buf;
+  struct __vramfs_export_header *header = (struct __vramfs_export_header *)cbuf;
+  header->magic = VRAMFS_EXPORT_MAGIC;
+  header->version = VRAMFS_EXPORT_VERSION;
+  header->nentries = nentries;
+  header->reserved = 0;
+  header->total_size = total;
+  cbuf += sizeof(struct __vramfs_export_header);
+
+  for (int i = 0; i < MAX_FILES; ++i) {
+    struct Entry *entref = vramfs + i;
+    if (!export_selected(entref, prefix, prefix_len))
+      continue;
+
+    size_t name_len = entry_path_len(entref);
+    struct Entry *inode = entry_inode(entref);
+    struct __vramfs_export_entry *record = (struct __vramfs_export_entry *)cbuf;
+    record->size = inode->size;
+    record->name_len = name_len;
+    record->reserved = 0;
+    cbuf += sizeof(struct __vramfs_export_entry);
+
+    memset(cbuf, 0, export_pad(name_len + 1));
+    entry_path(entref, cbuf, name_len);
+    cbuf += export_pad(name_len + 1);
+
+    if (inode->size) {
+      memset(cbuf + inode->size, 0, export_pad(inode->size) - inode->size);
+      if (entry_copy_out(inode, 0, cbuf, inode->size)) {
+        errno = ENOMEM;
+        return -1;
+      }
+    }
+    cbuf += export_pad(inode->size);
+  }
+
+  return total;
+}
+
+
+static int next_dirty_range(struct Entry *entref, unsigned long long since, size_t *block_ref, size_t *offset_ref, size_t *length_ref) {
+/* Finds the next range of the entry modified after since, starting at block *block_ref,
+ * and advances *block_ref past it. Returns 1 if there is such a range, 0 otherwise.
+ */
+  size_t nblocks = (entref->size + DIRTY_BLOCK - 1) / DIRTY_BLOCK;
+  size_t block = *block_ref;
+
+  // Without per-block generations, the whole file carries entref->gen
+  if (!entref->block_gen) {
+    if (block || !entref->size || entref->gen <= since)
+      return 0;
+    *offset_ref = 0;
+    *length_ref = entref->size;
+    *block_ref = nblocks;
+    return 1;
+  }
+
+  while (block < nblocks && entref->block_gen[block] <= since)
+    ++block;
+  if (block == nblocks)
+    return 0;
+
+  size_t first = block;
+  while (block < nblocks && entref->block_gen[block] > since)
+    ++block;
+
+  *offset_ref = first * DIRTY_BLOCK;
+  *length_ref = (block * DIRTY_BLOCK < entref->size ? block * DIRTY_BLOCK : entref->size) - *offset_ref;
+  *block_ref = block;
+  return 1;
+}
+
+unsigned long long
+__vramfs_generation (void) {
+  return __atomic_load_n(&fs_generation, __ATOMIC_RELAXED);
+}
+
+static unsigned long long path_generation(const struct Entry *entref) {
+/* The generation the entry's path came to be in: the newest of the name generations
+ * of the entry and its directories.
+ */
+  unsigned long long gen = 0;
+  for (; entref != &root_dir; entref = entref->parent)
+    gen = entref->name_gen > gen ? entref->name_gen : gen;
+  return gen;
+}
+
+static int delta_selected(struct Entry *entref, unsigned long long since, unsigned long long *from_ref) {
+/* Whether a delta since the given generation has a record for this name, and since
+ * which generation its data is sent: a path that is newer than since gets all of it.
+ */
+  if (entref->type != ENT_TYPE_REGULAR || !entry_is_live(entref) || !entref->parent)
+    return 0;
+  *from_ref = path_generation(entref) > since ? 0 : since;
+  return entry_inode(entref)->gen > *from_ref;
+}
+
+ssize_t
+__vramfs_delta (void *buf, size_t size, unsigned long long since) {
+
+  unsigned long long generation = __vramfs_generation();
+  int resync = since < __atomic_load_n(&reset_generation, __ATOMIC_RELAXED)
+               || since < __atomic_load_n(&removals.floor, __ATOMIC_RELAXED);
+  unsigned long long from = resync ? 0 : since;
+  size_t total = sizeof(struct __vramfs_delta_header);
+  unsigned int nentries = 0, nremovals = 0;
+  size_t block, offset, length;
+
+  // First pass: work out the size of the delta. A resync has no removals, the host starts over.
+  spin_lock(&removals.lock);
+  for (int i = 0; i < TOMBSTONES; ++i) {
+    if (!resync && removals.slots[i].gen > since) {
+      total += sizeof(struct __vramfs_delta_removal) + export_pad(removals.slots[i].len + 1);
+      ++nremovals;
+    }
+  }
+
+  for (int i = 0; i < MAX_FILES; ++i) {
+    struct Entry *entref = vramfs + i;
+    unsigned long long file_from;
+    if (!delta_selected(entref, from, &file_from))
+      continue;
+
+    size_t data_size = 0;
+    total += sizeof(struct __vramfs_delta_entry);
+    total += export_pad(entry_path_len(entref) + 1);
+    for (block = 0; next_dirty_range(entry_inode(entref), file_from, &block, &offset, &length); ) {
+      total += sizeof(struct __vramfs_delta_range);
+      data_size += length;
+    }
+    total += export_pad(data_size);
+    ++nentries;
+  }
+
+  if (!buf || size < total) {
+    spin_unlock(&removals.lock);
+    return total;
+  }
+
+  // Second pass: serialize, in the same order
+  char *cbuf = (char *)buf;
+  struct __vramfs_delta_header *header = (struct __vramfs_delta_header *)cbuf;
+  header->magic = VRAMFS_DELTA_MAGIC;
+  header->version = VRAMFS_DELTA_VERSION;
+  header->nentries = nentries;
+  header->flags = resync ? VRAMFS_DELTA_RESYNC : 0;
+  header->since = since;
+  header->generation = generation;
+  header->total_size = total;
+  header->nremovals = nremovals;
+  header->reserved = 0;
+  cbuf += sizeof(struct __vramfs_delta_header);
+
+  for (int i = 0; i < TOMBSTONES; ++i) {
+    if (resync || removals.slots[i].gen <= since)
+      continue;
+
+    size_t name_len = removals.slots[i].len;
+    struct __vramfs_delta_removal *record = (struct __vramfs_delta_removal *)cbuf;
+    record->name_len = name_len;
+    record->reserved = 0;
+    cbuf += sizeof(struct __vramfs_delta_removal);
+
+    memset(cbuf, 0, export_pad(name_len + 1));
+    memcpy(cbuf, removals.slots[i].path, name_len);
+    cbuf += export_pad(name_len + 1);
+  }
+  spin_unlock(&removals.lock);
+
+  for (int i = 0; i < MAX_FILES; ++i) {
+    struct Entry *entref = vramfs + i;
+    struct Entry *inode = entry_inode(entref);
+    unsigned long long file_from;
+    if (!delta_selected(entref, from, &file_from))
+      continue;
+
+    size_t name_len = entry_path_len(entref);
+    struct __vramfs_delta_entry *record = (struct __vramfs_delta_entry *)cbuf;
+    record->size = inode->size;
+    record->name_len = name_len;
+    record->nranges = 0;
+    cbuf += sizeof(struct __vramfs_delta_entry);
+
+    memset(cbuf, 0, export_pad(name_len + 1));
+    entry_path(entref, cbuf, name_len);
+    cbuf += export_pad(name_len + 1);
+
+    struct __vramfs_delta_range *range = (struct __vramfs_delta_range *)cbuf;
+    for (block = 0; next_dirty_range(inode, file_from, &block, &offset, &length); ++range) {
+      range->offset = offset;
+      range->length = length;
+      ++record->nranges;
+    }
+    cbuf = (char *)range;
+
+    size_t data_size = 0;
+    for (block = 0; next_dirty_range(inode, file_from, &block, &offset, &length); ) {
+      if (entry_copy_out(inode, offset, cbuf + data_size, length)) {
+        errno = ENOMEM;
+        return -1;
+      }
+      data_size += length;
+    }
+    memset(cbuf + data_size, 0, export_pad(data_size) - data_size);
+    cbuf += export_pad(data_size);
+  }
+
+  return total;
+}
+
+
+static void carry_entry(struct Entry *entref, unsigned int epoch) {
+/* Carries the entry and its directories over into the new epoch. */
+  for (; entref && entref->epoch != epoch; entref = entref->parent)
+    entref->epoch = epoch;
+}
+
+void
+__vramfs_reset (const char *const *keep) {
+
+  unsigned int epoch = fs_epoch + 1;
+
+  // Carry the root directory, /dev and the files to keep, with their directories, over into the new epoch
+  init_namespace();
+  root_dir.epoch = epoch;
+  dev_entries[0].epoch = epoch;
+  for (; keep && *keep; ++keep) {
+    struct Entry *entref;
+    if (find_entry(*keep, &entref) || (entref->type != ENT_TYPE_REGULAR && entref->type != ENT_TYPE_DIRECTORY))
+      continue;
+    struct Entry *inode = entry_inode(entref);
+    inode->nopen = 0;
+    carry_entry(entref, epoch);
+
+    // A file keeps all of its names, so that its link count stays right
+    if (entref->type == ENT_TYPE_REGULAR && inode->nlink > 1) {
+      for (int i = 0; i < MAX_FILES; ++i) {
+        if (vramfs[i].type == ENT_TYPE_REGULAR && entry_is_live(vramfs + i) && entry_inode(vramfs + i) == inode)
+          carry_entry(vramfs + i, epoch);
+      }
+    }
+    carry_entry(inode, epoch);
+  }
+
+  fs_epoch = epoch;
+  __atomic_store_n(&reset_generation, __atomic_add_fetch(&fs_generation, 1, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
 }
 
 /****************************************************************************************************/
+
+#endif /* VRAMFS_PROFILE_STDIO */
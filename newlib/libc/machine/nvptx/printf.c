@@ -15,7 +15,9 @@
 
 #include <stdarg.h>
 
-extern int vprintf (const char *, va_list);
+/* Either the CUDA-provided vprintf or binary logging; see log.c.  */
+extern int __nvptx_vprintf (const char *, va_list);
+extern void __nvptx_line_flush (void);
 
 int
 printf (const char *fmt, ...)
@@ -23,8 +25,11 @@ printf (const char *fmt, ...)
   va_list args;
   int res;
 
+  /* Keep a partial line from putchar ahead of this output.  */
+  __nvptx_line_flush ();
+
   va_start (args, fmt);
-  res = vprintf (fmt, args);
+  res = __nvptx_vprintf (fmt, args);
   va_end (args);
   return res;
 }
@@ -13,19 +13,12 @@
  * they apply.
  */
 
-#include <stdarg.h>
-
-extern int vprintf (const char *, va_list);
+/* Characters are assembled into lines; see linebuf.c.  */
+extern int __nvptx_line_putc (int);
 
 int
 putchar (int c)
 {
-  unsigned valist[1];
-
   c = (unsigned char)c;
-  valist[0] = c;
-  int ret = vprintf ("%c", valist);
-  if (ret < 0)
-    c = -1;
-  return c;
+  return __nvptx_line_putc (c);
 }
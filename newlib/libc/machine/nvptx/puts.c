@@ -13,15 +13,11 @@
  * they apply.
  */
 
-#include <stdarg.h>
-
-extern int vprintf (const char *, va_list);
+/* Completes a partial line left by putchar, if any; see linebuf.c.  */
+extern int __nvptx_line_puts (const char *);
 
 int
 puts (const char *str)
 {
-  void *valist[1];
-
-  valist[0] = str;
-  return vprintf ("%s\n", valist);
+  return __nvptx_line_puts (str);
 }
@@ -14,19 +14,29 @@
  */
 
 #include <stdlib.h>
+#include "machine/heapprof.h"
+#include "heap.h"
 
 void *
-realloc (void *old_ptr, size_t new_size)
+__nvptx_realloc_at (void *old_ptr, size_t new_size, const char *file,
+		    int line)
 {
-  void *new_ptr = malloc (new_size);
+  void *new_ptr = __nvptx_malloc_at (new_size, file, line);
 
   if (old_ptr && new_ptr)
     {
-      size_t old_size = *(size_t *)((long long *)old_ptr - 1);
+      size_t old_size = heap_header (old_ptr)->size;
       size_t copy_size = old_size > new_size ? new_size : old_size;
       __builtin_memcpy (new_ptr, old_ptr, copy_size);
+      __nvptx_heap_note_copy (copy_size);
       free (old_ptr);
     }
 
   return new_ptr;
 }
+
+void *
+realloc (void *old_ptr, size_t new_size)
+{
+  return __nvptx_realloc_at (old_ptr, new_size, NULL, 0);
+}
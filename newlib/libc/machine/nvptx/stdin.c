@@ -0,0 +1,98 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Reading standard input from the ring buffer the host fills while the
+   kernel runs; see machine/vramfs.h for the protocol.  Used by both the
+   file system (misc.c) and the stdio-only build (streams.c).
+
+   Readers copy the bytes out first and claim them by advancing tail
+   afterwards: if no other reader moved tail in the meantime, the host
+   couldn't have reused the space of those bytes either, so the copy is
+   good.  Otherwise, it's retried with the new tail.  */
+
+#include <errno.h>
+#ifndef __nvptx__
+#include <sched.h>
+#endif
+#include <string.h>
+#include <sys/types.h>
+#include "machine/vramfs.h"
+
+struct __vramfs_stdin __vramfs_stdin;
+
+/* Wait a little before looking at the ring again.  */
+
+static void
+stdin_backoff (void)
+{
+#ifndef __nvptx__
+  sched_yield ();		/* On the host, where the tests run.  */
+#elif __PTX_SM__ >= 700
+  asm volatile ("nanosleep.u32 %0;" :: "r" (1000));
+#endif
+}
+
+/* Take up to COUNT bytes out of the ring into BUF.  Returns the number of
+   bytes taken, 0 at end of file or if the ring isn't enabled, or -1 with
+   errno set to EAGAIN if the ring is empty and nonblock is set.  */
+
+ssize_t
+__nvptx_stdin_read (void *buf, size_t count)
+{
+  struct __vramfs_stdin *in = &__vramfs_stdin;
+
+  if (!__atomic_load_n (&in->enabled, __ATOMIC_ACQUIRE) || !count)
+    return 0;
+
+  unsigned long long tail = __atomic_load_n (&in->tail, __ATOMIC_ACQUIRE);
+  for (;;)
+    {
+      unsigned long long head = __atomic_load_n (&in->head, __ATOMIC_ACQUIRE);
+      unsigned long long avail = head - tail;
+
+      /* A tail that went stale while we waited may be a full ring behind.  */
+      if (avail > VRAMFS_STDIN_SIZE)
+	{
+	  tail = __atomic_load_n (&in->tail, __ATOMIC_ACQUIRE);
+	  continue;
+	}
+
+      if (!avail)
+	{
+	  /* Input that came in before closed was set is still read.  */
+	  if (__atomic_load_n (&in->closed, __ATOMIC_ACQUIRE)
+	      && __atomic_load_n (&in->head, __ATOMIC_ACQUIRE) == tail)
+	    return 0;
+	  if (__atomic_load_n (&in->nonblock, __ATOMIC_RELAXED))
+	    {
+	      errno = EAGAIN;
+	      return -1;
+	    }
+	  stdin_backoff ();
+	  tail = __atomic_load_n (&in->tail, __ATOMIC_ACQUIRE);
+	  continue;
+	}
+
+      size_t n = avail < count ? avail : count;
+      size_t at = tail % VRAMFS_STDIN_SIZE;
+      size_t first = n < VRAMFS_STDIN_SIZE - at ? n : VRAMFS_STDIN_SIZE - at;
+      memcpy (buf, in->data + at, first);
+      memcpy ((char *) buf + first, in->data, n - first);
+
+      if (__atomic_compare_exchange_n (&in->tail, &tail, tail + n, 0,
+				       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+	return n;
+    }
+}
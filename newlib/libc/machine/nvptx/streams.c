@@ -0,0 +1,161 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* System calls of the stdio-only build (VRAMFS_PROFILE_STDIO, see
+   Makefile.inc), for programs that print but don't use files.  This
+   replaces the file system in misc.c: fd 0 reads the ring buffer the host
+   feeds (stdin.c), fd 1 and fd 2 go to printf through the line buffers of
+   putchar, and there are no other files to open.  */
+
+#ifdef VRAMFS_PROFILE_STDIO
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#undef errno
+extern int errno;
+
+extern ssize_t __nvptx_stdin_read (void *, size_t);
+
+int
+close (int fd)
+{
+  /* The standard streams are never actually closed.  */
+  if (fd < 0 || fd > 2)
+    {
+      errno = EBADF;
+      return -1;
+    }
+  return 0;
+}
+
+int
+fstat (int fd, struct stat *buf)
+{
+  if (fd < 0 || fd > 2)
+    {
+      errno = EBADF;
+      return -1;
+    }
+  if (!buf)
+    {
+      errno = EFAULT;
+      return -1;
+    }
+
+  memset (buf, 0, sizeof (struct stat));
+  buf->st_mode = S_IFCHR | 0666;
+  buf->st_nlink = 1;
+  return 0;
+}
+
+int
+getpid (void)
+{
+  return 0;
+}
+
+int
+isatty (int fd)
+{
+  return fd == 1;
+}
+
+int
+kill (int pid, int sig)
+{
+  errno = ESRCH;
+  return -1;
+}
+
+off_t
+lseek (int fd, off_t offset, int whence)
+{
+  errno = fd < 0 || fd > 2 ? EBADF : ESPIPE;
+  return -1;
+}
+
+int
+open (const char *pathname, int flags, ...)
+{
+  errno = ENOENT;
+  return -1;
+}
+
+ssize_t
+read (int fd, void *buf, size_t count)
+{
+  if (fd < 0 || fd > 2)
+    {
+      errno = EBADF;
+      return -1;
+    }
+  if (fd)
+    return 0;
+  if (!buf && count)
+    {
+      errno = EFAULT;
+      return -1;
+    }
+  return __nvptx_stdin_read (buf, count);
+}
+
+ssize_t
+write (int fd, const void *buf, size_t count)
+{
+  if (fd < 0 || fd > 2)
+    {
+      errno = EBADF;
+      return -1;
+    }
+  if (!buf && count)
+    {
+      errno = EFAULT;
+      return -1;
+    }
+  if (!fd)
+    return count;
+
+  const unsigned char *cbuf = (const unsigned char *) buf;
+  size_t i;
+  for (i = 0; i < count; i++)
+    if (putchar (cbuf[i]) < 0)
+      break;
+  return i;
+}
+
+int
+stat (const char *file, struct stat *pstat)
+{
+  errno = ENOENT;
+  return -1;
+}
+
+void
+sync (void)
+{
+}
+
+int
+unlink (const char *pathname)
+{
+  errno = ENOENT;
+  return -1;
+}
+
+#endif /* VRAMFS_PROFILE_STDIO */
@@ -0,0 +1,65 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Directory streams of the nvptx in-memory file system (vramfs).  This
+   replaces the generic <sys/dirent.h>, which doesn't support <dirent.h>.  */
+
+#ifndef _SYS_DIRENT_H
+#define _SYS_DIRENT_H
+
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Longest file name component, without the nul.  */
+#define MAXNAMLEN 31
+
+#define DT_UNKNOWN 0
+#define DT_CHR 2
+#define DT_DIR 4
+#define DT_REG 8
+
+struct dirent
+{
+  ino_t d_ino;
+  unsigned char d_type;
+  char d_name[MAXNAMLEN + 1];
+};
+
+/* A directory stream walks the list of children of its directory, so a
+   listing costs time in the number of children only.  The "." and ".."
+   entries are not listed.  Entries created while a stream is open may or
+   may not be returned, and removing the entry the stream would return next
+   ends the listing early.  */
+typedef struct
+{
+  void *__dir;			/* The directory's vramfs entry.  */
+  void *__next;			/* The next child to return.  */
+  unsigned int __incarnation;	/* Identifies the list __next belongs to.  */
+  struct dirent __ent;		/* Storage for readdir's result.  */
+} DIR;
+
+extern DIR *opendir (const char *);
+extern struct dirent *readdir (DIR *);
+extern void rewinddir (DIR *);
+extern int closedir (DIR *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SYS_DIRENT_H */
@@ -0,0 +1,39 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* sendfile for the nvptx in-memory file system (vramfs).  */
+
+#ifndef _SYS_SENDFILE_H
+#define _SYS_SENDFILE_H
+
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Write up to COUNT bytes of the regular file IN_FD to OUT_FD, starting at
+   *OFFSET, which is advanced, or at the file offset of IN_FD if OFFSET is
+   NULL.  The data goes straight from one file to the other; the standard
+   streams take it in large printf records.  Returns the number of bytes
+   written, or -1 with errno set.  */
+extern ssize_t sendfile (int __out_fd, int __in_fd, off_t *__offset,
+			 size_t __count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SYS_SENDFILE_H */
@@ -0,0 +1,106 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Host test of the counter arithmetic of clock.c: the split products
+   must equal the exact ones, computed in 128 bits, over the whole range
+   they are documented for, and calibration must recover the rate a
+   simulated counter runs at.  */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "clockmath.h"
+
+typedef unsigned __int128 u128;
+
+static unsigned long long
+random64 (void)
+{
+  return (unsigned long long) rand () << 62 ^ (unsigned long long) rand () << 31
+	 ^ rand ();
+}
+
+static void
+check_rate (unsigned long long cycles, unsigned long long ns)
+{
+  u128 exact = (u128) cycles * NSEC_PER_SEC / ns;
+  if (exact >> 64)
+    return;
+  assert (clock_rate (cycles, ns) == (unsigned long long) exact);
+}
+
+static void
+check_ns (unsigned long long cycles, unsigned long long hz)
+{
+  u128 exact = (u128) cycles * NSEC_PER_SEC / hz;
+  if (exact >> 64)
+    return;
+  assert (cycles_to_ns (cycles, hz) == (unsigned long long) exact);
+}
+
+int
+main (void)
+{
+  srand (1);
+
+  /* Exact at the edges and across the documented ranges: NS below 18 s,
+     HZ below 18 GHz, with counters up to their full 64 bits.  */
+  static const unsigned long long edges[]
+    = { 0, 1, 999999999, NSEC_PER_SEC, NSEC_PER_SEC + 1, 1ull << 32,
+	18000000000ull, ~0ull >> 1, ~0ull };
+  for (size_t i = 0; i < sizeof edges / sizeof edges[0]; ++i)
+    for (size_t j = 0; j < sizeof edges / sizeof edges[0]; ++j)
+      if (edges[j] && edges[j] <= 18000000000ull)
+	{
+	  check_rate (edges[i], edges[j]);
+	  check_ns (edges[i], edges[j]);
+	}
+
+  for (int i = 0; i < 1000000; ++i)
+    {
+      unsigned long long cycles = random64 () >> (rand () % 64);
+      unsigned long long period = random64 () % 18000000000ull + 1;
+      check_rate (cycles, period);
+      check_ns (cycles, period);
+    }
+
+  assert (clock_rate (12345, 0) == 0);
+
+  /* Calibration over the 1 ms that __nvptx_clock_calibrate spins, with
+     the timer read a little late, recovers the rate to within a
+     thousandth, and converting back gives the measured interval.  */
+  static const unsigned long long rates[]
+    = { 705000000ull, 1250000000ull, 1410000000ull, 2100000000ull };
+  for (size_t i = 0; i < sizeof rates / sizeof rates[0]; ++i)
+    for (unsigned long long ns = 1000000; ns < 1002000; ns += 37)
+      {
+	unsigned long long cycles = (u128) ns * rates[i] / NSEC_PER_SEC;
+	unsigned long long start = random64 ();
+	unsigned long long hz = clock_rate (start + cycles - start, ns);
+	assert (hz > rates[i] - rates[i] / 1000 && hz <= rates[i]);
+	unsigned long long back = cycles_to_ns (cycles, hz);
+	assert (back >= ns && back - ns <= ns / 1000);
+      }
+
+  /* Until a rate is known, %clock64 counts at the default rate, and one
+     cycle still takes a nanosecond or less.  */
+  assert (clock64_to_ns (CLOCK64_DEFAULT_HZ, 0) == NSEC_PER_SEC);
+  assert (clock64_to_ns (CLOCK64_DEFAULT_HZ, 2 * CLOCK64_DEFAULT_HZ)
+	  == NSEC_PER_SEC / 2);
+  assert (clock64_to_ns (1, 0) == 0);
+
+  puts ("clock-test: ok");
+  return 0;
+}
@@ -0,0 +1,209 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Host test of vramfs deduplication: threads, each a team of its own,
+   write files that are the same but for one block, and the files must
+   read back as written while only the blocks that differ are stored
+   twice.  Run with the argument "bench" to print the write throughput
+   with deduplication off and on, next to __vramfs_dedup_stats.  The host
+   has no cycle counter, so hash_cycles stays 0 there.  */
+
+#include "vramfs-host.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "machine/vramfs.h"
+
+#define THREADS 8
+#define FILES 4
+#define BLOCK 4096
+#define BLOCKS 16
+
+static int rounds = 1;
+
+/* Block N of file FILE of thread THREAD: all files share their blocks
+   but one, which is the file's own.  */
+
+static void
+fill_block (char *buf, int thread, int file, int n)
+{
+  for (int i = 0; i < BLOCK; ++i)
+    buf[i] = 'A' + (n + i) % 26;
+  if (n == file % BLOCKS)
+    snprintf (buf, BLOCK, "own block of thread %d file %d", thread, file);
+}
+
+static void
+file_name (char *name, size_t size, int thread, int file)
+{
+  snprintf (name, size, "/t%d.%d", thread, file);
+}
+
+/* Write the thread's files ROUNDS times over.  */
+
+static void *
+writer (void *arg)
+{
+  int thread = (long) arg;
+  static __thread char data[BLOCKS * BLOCK];
+
+  for (int round = 0; round < rounds; ++round)
+    for (int file = 0; file < FILES; ++file)
+      {
+	char name[32];
+	file_name (name, sizeof name, thread, file);
+	for (int n = 0; n < BLOCKS; ++n)
+	  fill_block (data + n * BLOCK, thread, file, n);
+	int fd = open (name, O_WRONLY | O_CREAT | O_TRUNC);
+	assert (fd >= 3);
+	assert (write (fd, data, sizeof data) == sizeof data);
+	assert (close (fd) == 0);
+      }
+  return NULL;
+}
+
+/* Run writer on every thread, returning the elapsed seconds.  */
+
+static double
+run_writers (void)
+{
+  pthread_t threads[THREADS];
+  struct timespec start, end;
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (long i = 0; i < THREADS; ++i)
+    assert (pthread_create (&threads[i], NULL, writer, (void *) i) == 0);
+  for (int i = 0; i < THREADS; ++i)
+    pthread_join (threads[i], NULL);
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return end.tv_sec - start.tv_sec + (end.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+/* Every file must read back as written.  */
+
+static void
+check_files (void)
+{
+  static char back[BLOCKS * BLOCK + 1];
+  char want[BLOCK];
+
+  for (int thread = 0; thread < THREADS; ++thread)
+    for (int file = 0; file < FILES; ++file)
+      {
+	char name[32];
+	file_name (name, sizeof name, thread, file);
+	int fd = open (name, O_RDONLY);
+	assert (fd >= 3);
+	assert (read (fd, back, sizeof back) == BLOCKS * BLOCK);
+	assert (close (fd) == 0);
+	for (int n = 0; n < BLOCKS; ++n)
+	  {
+	    fill_block (want, thread, file, n);
+	    assert (memcmp (back + n * BLOCK, want, BLOCK) == 0);
+	  }
+      }
+}
+
+static void
+remove_files (void)
+{
+  for (int thread = 0; thread < THREADS; ++thread)
+    for (int file = 0; file < FILES; ++file)
+      {
+	char name[32];
+	file_name (name, sizeof name, thread, file);
+	assert (unlink (name) == 0);
+      }
+}
+
+static void
+bench (void)
+{
+  rounds = 50;
+  for (__vramfs_dedup_enabled = 0; __vramfs_dedup_enabled < 2;
+       ++__vramfs_dedup_enabled)
+    {
+      memset (&__vramfs_dedup_stats, 0, sizeof __vramfs_dedup_stats);
+      double secs = run_writers ();
+      const struct __vramfs_dedup_stats *stats = &__vramfs_dedup_stats;
+      printf ("dedup %-3s %8.1f MB/s  logical %8llu  stored %8llu"
+	      "  ratio %5.2f  shared %6llu  hash cycles %llu\n",
+	      __vramfs_dedup_enabled ? "on" : "off",
+	      (double) THREADS * FILES * BLOCKS * BLOCK * rounds / secs / 1e6,
+	      stats->logical_bytes, stats->stored_bytes,
+	      stats->stored_bytes
+	      ? (double) stats->logical_bytes / stats->stored_bytes : 1.0,
+	      stats->blocks_shared, stats->hash_cycles);
+      remove_files ();
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc > 1 && strcmp (argv[1], "bench") == 0)
+    {
+      bench ();
+      return 0;
+    }
+
+  /* Without deduplication, files keep their data to themselves.  */
+  run_writers ();
+  check_files ();
+  assert (__vramfs_dedup_stats.logical_bytes == 0);
+  remove_files ();
+
+  /* With it, the shared blocks are stored once, and each file's own
+     block once more.  */
+  __vramfs_dedup_enabled = 1;
+  rounds = 2;
+  run_writers ();
+  check_files ();
+  const unsigned long long nfiles = THREADS * FILES;
+  assert (__vramfs_dedup_stats.logical_bytes == nfiles * BLOCKS * BLOCK);
+  assert (__vramfs_dedup_stats.stored_bytes == (BLOCKS + nfiles) * BLOCK);
+
+  /* A file written to again gets a copy of its own, and the others are
+     left alone.  */
+  int fd = open ("/t0.0", O_RDWR);
+  assert (fd >= 3);
+  assert (lseek (fd, BLOCK + 1, SEEK_SET) == BLOCK + 1);
+  assert (write (fd, "B", 1) == 1);
+  assert (close (fd) == 0);
+  char c;
+  fd = open ("/t0.0", O_RDONLY);
+  assert (fd >= 3);
+  assert (lseek (fd, BLOCK + 1, SEEK_SET) == BLOCK + 1);
+  assert (read (fd, &c, 1) == 1 && c == 'B');
+  assert (close (fd) == 0);
+  fd = open ("/t1.0", O_RDONLY);
+  assert (fd >= 3);
+  assert (lseek (fd, BLOCK + 1, SEEK_SET) == BLOCK + 1);
+  assert (read (fd, &c, 1) == 1 && c == 'A' + (1 + 1) % 26);
+  assert (close (fd) == 0);
+
+  /* Once all files are gone, so are their blocks.  */
+  remove_files ();
+  assert (__vramfs_dedup_stats.logical_bytes == 0);
+  assert (__vramfs_dedup_stats.stored_bytes == 0);
+
+  puts ("dedup-test: ok");
+  return 0;
+}
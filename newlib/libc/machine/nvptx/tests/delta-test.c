@@ -0,0 +1,152 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Host test of __vramfs_delta and __vramfs_apply_delta: random writes,
+   renames, links, removals and resets are made to vramfs, and a host
+   directory kept up to date by applying deltas alone must always hold
+   what an export of vramfs unpacks to.  */
+
+#include "vramfs-host.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "machine/vramfs.h"
+#include "hostdir.h"
+
+static char blob[1 << 20] __attribute__ ((aligned (8)));
+
+/* The host's copy, kept up to date by applying deltas alone.  */
+static const char *copy_dir;
+
+/* The host's copy has to match an export of all files.  */
+
+static void
+check_copy (void)
+{
+  ssize_t total = __vramfs_export (blob, sizeof blob, NULL);
+  assert (total > 0 && (size_t) total <= sizeof blob);
+
+  const char *dir = hostdir_make ();
+  assert (__vramfs_unpack (blob, total, dir) == 0);
+  assert (hostdir_equal (copy_dir, dir));
+  hostdir_remove (dir);
+}
+
+static const char *const dirs[] = { "", "/a", "/b", "/a/c" };
+
+static void
+random_path (char *buf, size_t size)
+{
+  snprintf (buf, size, "%s/f%d", dirs[rand () % 4], rand () % 4);
+}
+
+static void
+random_op (void)
+{
+  static char data[3 * 4096];
+  char path[64], other[64];
+  random_path (path, sizeof path);
+  random_path (other, sizeof other);
+
+  int fd;
+  switch (rand () % 9)
+    {
+    case 0:
+    case 1:
+      /* Overwrite some of a file, possibly growing it.  */
+      fd = open (path, O_RDWR | O_CREAT | O_APPEND);
+      if (fd < 0)
+	break;
+      close (fd);
+      fd = open (path, O_RDWR);
+      if (fd < 0)
+	break;
+      memset (data, 'a' + rand () % 26, sizeof data);
+      lseek (fd, rand () % sizeof data, SEEK_SET);
+      write (fd, data, rand () % sizeof data);
+      close (fd);
+      break;
+    case 2:
+      fd = open (path, O_WRONLY | O_CREAT | O_TRUNC);
+      if (fd >= 0)
+	{
+	  write (fd, path, strlen (path));
+	  close (fd);
+	}
+      break;
+    case 3:
+      rename (path, other);
+      break;
+    case 4:
+      link (path, other);
+      break;
+    case 5:
+      unlink (path);
+      break;
+    case 6:
+      /* Move a whole directory, and back another time.  */
+      if (rename ("/a/c", "/b/c") != 0)
+	rename ("/b/c", "/a/c");
+      break;
+    case 7:
+      if (rmdir (dirs[1 + rand () % 3]) != 0)
+	mkdir (dirs[1 + rand () % 3], 0777);
+      break;
+    case 8:
+      if (rand () % 8 == 0)
+	{
+	  const char *keep[] = { path, NULL };
+	  __vramfs_reset (keep);
+	}
+      break;
+    }
+}
+
+int
+main (void)
+{
+  mkdir ("/a", 0777);
+  mkdir ("/b", 0777);
+  mkdir ("/a/c", 0777);
+  srand (1);
+  copy_dir = hostdir_make ();
+
+  unsigned long long since = 0;
+  for (int round = 0; round < 2000; ++round)
+    {
+      for (int i = rand () % 8; i >= 0; --i)
+	random_op ();
+
+      ssize_t total = __vramfs_delta (blob, sizeof blob, since);
+      assert (total > 0 && (size_t) total <= sizeof blob);
+      since = ((struct __vramfs_delta_header *) blob)->generation;
+      assert (__vramfs_apply_delta (blob, total, copy_dir) == 0);
+      check_copy ();
+    }
+
+  /* Nothing changed, nothing to send.  */
+  __vramfs_delta (blob, sizeof blob, since);
+  const struct __vramfs_delta_header *header = (const void *) blob;
+  assert (header->nentries == 0 && header->nremovals == 0 && !header->flags);
+
+  hostdir_remove (copy_dir);
+  puts ("delta-test: ok");
+  return 0;
+}
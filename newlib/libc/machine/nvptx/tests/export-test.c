@@ -0,0 +1,122 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Host test of __vramfs_unpack: files written to vramfs, exported and
+   unpacked into a host directory must be there with the same contents,
+   and blobs that are cut short, aren't exports, or have paths that reach
+   outside of the directory must be refused.  */
+
+#include "vramfs-host.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "machine/vramfs.h"
+#include "hostdir.h"
+
+static char blob[1 << 20] __attribute__ ((aligned (8)));
+static char data[200000];
+static char back[sizeof data + 1];
+
+static const struct
+{
+  const char *path;
+  size_t size;
+} files[] = {
+  { "/top.txt", 12 },
+  { "/a/empty", 0 },
+  { "/a/b/c/deep.bin", 10000 },
+  { "/a/b/big", sizeof data },
+};
+
+static void
+write_file (const char *path, const char *buf, size_t size)
+{
+  int fd = open (path, O_WRONLY | O_CREAT | O_TRUNC);
+  assert (fd >= 0);
+  assert (!size || write (fd, buf, size) == (ssize_t) size);
+  assert (close (fd) == 0);
+}
+
+int
+main (void)
+{
+  /* Data with nul bytes in it, repetitive enough to be compressed.  */
+  for (size_t i = 0; i < sizeof data; ++i)
+    data[i] = i % 3 ? 0 : 'a' + i / 1000 % 26;
+
+  assert (mkdir ("/a", 0777) == 0);
+  assert (mkdir ("/a/b", 0777) == 0);
+  assert (mkdir ("/a/b/c", 0777) == 0);
+  for (size_t i = 0; i < sizeof files / sizeof files[0]; ++i)
+    write_file (files[i].path, data, files[i].size);
+  assert (link ("/top.txt", "/a/alias") == 0);
+
+  ssize_t size = __vramfs_export (blob, sizeof blob, NULL);
+  assert (size > 0 && (size_t) size <= sizeof blob);
+
+  const char *dir = hostdir_make ();
+  assert (__vramfs_unpack (blob, size, dir) == 0);
+  /* Again, over the files that are there now.  */
+  assert (__vramfs_unpack (blob, size, dir) == 0);
+
+  assert (hostdir_count (dir) == 5);
+  for (size_t i = 0; i < sizeof files / sizeof files[0]; ++i)
+    {
+      assert (hostdir_read (dir, files[i].path, back, sizeof back)
+	      == (ssize_t) files[i].size);
+      assert (memcmp (back, data, files[i].size) == 0);
+    }
+  assert (hostdir_read (dir, "/a/alias", back, sizeof back) == 12);
+
+  /* Cut short, or not an export at all.  */
+  errno = 0;
+  assert (__vramfs_unpack (blob, size - 8, dir) == -1 && errno == EINVAL);
+  errno = 0;
+  assert (__vramfs_unpack (blob, 4, dir) == -1 && errno == EINVAL);
+  ((struct __vramfs_export_header *) blob)->magic ^= 1;
+  errno = 0;
+  assert (__vramfs_unpack (blob, size, dir) == -1 && errno == EINVAL);
+
+  /* Paths that would leave the directory.  */
+  static const char *const bad[] = { "/../escape", "/a/../../escape",
+				     "relative", "/a//b", "/./x" };
+  for (size_t i = 0; i < sizeof bad / sizeof bad[0]; ++i)
+    {
+      struct __vramfs_export_header *header = (void *) blob;
+      struct __vramfs_export_entry *rec = (void *) (header + 1);
+      char *name = (char *) (rec + 1);
+      memset (blob, 0, 256);
+      header->magic = VRAMFS_EXPORT_MAGIC;
+      header->version = VRAMFS_EXPORT_VERSION;
+      header->nentries = 1;
+      rec->name_len = strlen (bad[i]);
+      strcpy (name, bad[i]);
+      header->total_size = (name + ((rec->name_len + 8) & ~7)) - blob;
+      errno = 0;
+      assert (__vramfs_unpack (blob, sizeof blob, dir) == -1
+	      && errno == EINVAL);
+    }
+  assert (hostdir_count (dir) == 5);
+
+  hostdir_remove (dir);
+  puts ("export-test: ok");
+  return 0;
+}
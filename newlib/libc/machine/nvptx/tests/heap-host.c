@@ -0,0 +1,24 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* The heap with its functions renamed; see heap-host.h.  */
+
+#include "heap-host.h"
+#include "../malloc.c"
+#include "../calloc.c"
+#include "../realloc.c"
+#include "../memalign.c"
+#include "../free.c"
+#include "../heappool.c"
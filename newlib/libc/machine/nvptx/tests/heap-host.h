@@ -0,0 +1,32 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Host tests build the heap (through heap-host.c) next to the host's C
+   library, so its functions are renamed from malloc to nvptx_malloc and
+   so on.  The CUDA heap underneath is the host's malloc and free.
+   Include this first, in the test and in heap-host.c alike.  */
+
+#ifndef _NVPTX_HEAP_HOST_H_
+#define _NVPTX_HEAP_HOST_H_
+
+#define malloc nvptx_malloc
+#define calloc nvptx_calloc
+#define realloc nvptx_realloc
+#define free nvptx_free
+#define memalign nvptx_memalign
+#define aligned_alloc nvptx_aligned_alloc
+#define posix_memalign nvptx_posix_memalign
+
+#endif /* _NVPTX_HEAP_HOST_H_ */
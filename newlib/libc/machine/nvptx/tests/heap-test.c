@@ -0,0 +1,240 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Host test of the heap and its pools: calloc must hand out zeroed
+   memory whether its block comes from the CUDA heap, a dirty pool or a
+   scrubbed one, with threads allocating, freeing and scrubbing at once,
+   and every allocation function must give the pools back and try again
+   when the CUDA heap runs out.  Run with the argument "bench" to time
+   calloc with live sets of various sizes, and count the blocks taken from
+   the CUDA heap.
+
+   The CUDA heap is the host's malloc and free, wrapped (by linking with
+   --wrap=malloc,--wrap=free) to count calls and to fail on demand.  */
+
+#include "heap-host.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "machine/heappool.h"
+
+#define THREADS 8
+
+void *__real_malloc (size_t);
+void __real_free (void *);
+
+static unsigned long cuda_mallocs, cuda_frees;
+static int cuda_failures;
+
+void *
+__wrap_malloc (size_t size)
+{
+  __atomic_add_fetch (&cuda_mallocs, 1, __ATOMIC_RELAXED);
+  if (__atomic_load_n (&cuda_failures, __ATOMIC_RELAXED))
+    {
+      __atomic_sub_fetch (&cuda_failures, 1, __ATOMIC_RELAXED);
+      return NULL;
+    }
+  return __real_malloc (size);
+}
+
+void
+__wrap_free (void *ptr)
+{
+  __atomic_add_fetch (&cuda_frees, 1, __ATOMIC_RELAXED);
+  __real_free (ptr);
+}
+
+static int
+is_zero (const unsigned char *p, size_t n)
+{
+  for (size_t i = 0; i < n; ++i)
+    if (p[i])
+      return 0;
+  return 1;
+}
+
+/* Random calloc and malloc, each block dirtied before it's freed, with a
+   scrub now and then.  */
+
+static void *
+churn (void *arg)
+{
+  unsigned int seed = (unsigned int) (long) arg;
+  void *keep[16] = { 0 };
+
+  for (int i = 0; i < 20000; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      size_t n = 1 + (seed >> 16) % 2000;
+      int k = (seed >> 8) % 16;
+      free (keep[k]);
+      unsigned char *p;
+      if (seed & 1)
+	{
+	  p = calloc (n, 1);
+	  assert (p && is_zero (p, n));
+	}
+      else
+	p = malloc (n);
+      memset (p, 0x5a, n);
+      keep[k] = p;
+      if (i % 1000 == 0)
+	__nvptx_heap_scrub (i % 2000 ? 4096 : 0);
+    }
+  for (int k = 0; k < 16; ++k)
+    free (keep[k]);
+  return NULL;
+}
+
+/* Fill the pools with freed blocks, then have the CUDA heap fail once:
+   ALLOC must drain the pools and get its block on a second try.  */
+
+static void
+check_drain (void *(*alloc) (size_t), size_t size)
+{
+  void *blocks[32];
+  for (int i = 0; i < 32; ++i)
+    blocks[i] = malloc (100);
+  for (int i = 0; i < 32; ++i)
+    free (blocks[i]);
+
+  unsigned long frees = cuda_frees;
+  cuda_failures = 1;
+  void *p = alloc (size);
+  assert (p && !cuda_failures);
+  assert (cuda_frees - frees >= 32);
+  free (p);
+}
+
+static void *
+alloc_malloc (size_t size)
+{
+  return malloc (size);
+}
+
+static void *
+alloc_calloc (size_t size)
+{
+  return calloc (1, size);
+}
+
+static void *
+alloc_memalign (size_t size)
+{
+  void *p = memalign (256, size);
+  assert (((uintptr_t) p & 255) == 0);
+  return p;
+}
+
+static double
+seconds (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* calloc LIVE blocks of random sizes below 1000 bytes at a time, then free
+   them all, over and over; with SCRUB, the pools are scrubbed between
+   rounds, as a program with idle time would.  */
+
+static void
+bench (int live, int scrub)
+{
+  static void *blocks[1024];
+  unsigned int seed = 1;
+  double secs = 0;
+
+  __nvptx_heap_drain ();
+  unsigned long mallocs = cuda_mallocs;
+  for (int round = 0; round < 200000 / live; ++round)
+    {
+      double start = seconds ();
+      for (int i = 0; i < live; ++i)
+	{
+	  seed = seed * 1103515245 + 12345;
+	  blocks[i] = calloc (1, 1 + (seed >> 16) % 1000);
+	}
+      secs += seconds () - start;
+      for (int i = 0; i < live; ++i)
+	free (blocks[i]);
+      if (scrub)
+	__nvptx_heap_scrub (0);
+    }
+  printf ("live %4d: calloc %6.3f s, %7lu blocks from the CUDA heap%s\n",
+	  live, secs, cuda_mallocs - mallocs,
+	  scrub ? " (scrubbed between rounds)" : "");
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc > 1 && strcmp (argv[1], "bench") == 0)
+    {
+      for (int live = 16; live <= 1024; live *= 4)
+	for (int scrub = 0; scrub < 2; ++scrub)
+	  bench (live, scrub);
+      return 0;
+    }
+
+  /* Sizes that overflow are refused.  Hidden from the compiler, which
+     would warn about them.  */
+  volatile size_t half = SIZE_MAX / 2, big = (size_t) 1 << 33;
+  errno = 0;
+  assert (!calloc (half, 3) && errno == ENOMEM);
+  assert (!calloc (big, big));
+
+  /* Blocks that come back from the pools dirty are zeroed, in whole.  */
+  for (int round = 0; round < 100; ++round)
+    {
+      void *blocks[64];
+      for (int i = 0; i < 64; ++i)
+	{
+	  size_t n = 1 + (round * 64 + i) * 37 % 3000;
+	  blocks[i] = calloc (n, 1);
+	  assert (blocks[i] && is_zero (blocks[i], n));
+	  memset (blocks[i], 0xab, n);
+	}
+      for (int i = 0; i < 64; ++i)
+	free (blocks[i]);
+      if (round % 3 == 0)
+	__nvptx_heap_scrub (round % 2 ? 0 : 8192);
+    }
+
+  pthread_t threads[THREADS];
+  for (long i = 0; i < THREADS; ++i)
+    assert (pthread_create (&threads[i], NULL, churn, (void *) (i + 1)) == 0);
+  for (int i = 0; i < THREADS; ++i)
+    pthread_join (threads[i], NULL);
+
+  check_drain (alloc_malloc, 5000);
+  check_drain (alloc_calloc, 5000);
+  check_drain (alloc_memalign, 5000);
+
+  /* Nothing is left over once the pools are drained.  */
+  __nvptx_heap_drain ();
+  assert (cuda_mallocs - 3 == cuda_frees);
+
+  puts ("heap-test: ok");
+  return 0;
+}
@@ -0,0 +1,121 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Directories of the host for tests; see hostdir.h.  */
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "hostdir.h"
+
+const char *
+hostdir_make (void)
+{
+  const char *tmp = getenv ("TMPDIR");
+  char *dir;
+  assert (asprintf (&dir, "%s/vramfs-XXXXXX", tmp ? tmp : "/tmp") > 0);
+  assert (mkdtemp (dir));
+  return dir;
+}
+
+static int
+remove_one (const char *path, const struct stat *st, int type,
+	    struct FTW *ftw)
+{
+  (void) st;
+  (void) type;
+  (void) ftw;
+  return remove (path);
+}
+
+void
+hostdir_remove (const char *dir)
+{
+  nftw (dir, remove_one, 16, FTW_DEPTH | FTW_PHYS);
+  free ((char *) dir);
+}
+
+ssize_t
+hostdir_read (const char *dir, const char *path, void *buf, size_t size)
+{
+  char full[4096];
+  snprintf (full, sizeof full, "%s%s", dir, path);
+  int fd = open (full, O_RDONLY);
+  if (fd < 0)
+    return -1;
+  ssize_t n = read (fd, buf, size);
+  close (fd);
+  return n;
+}
+
+static int nfiles;
+
+static int
+count_one (const char *path, const struct stat *st, int type,
+	   struct FTW *ftw)
+{
+  (void) path;
+  (void) st;
+  (void) ftw;
+  nfiles += type == FTW_F;
+  return 0;
+}
+
+int
+hostdir_count (const char *dir)
+{
+  nfiles = 0;
+  nftw (dir, count_one, 16, FTW_PHYS);
+  return nfiles;
+}
+
+static const char *other_dir;
+static size_t root_len;
+static int differ;
+
+/* Compare a file below the first directory with its counterpart.  */
+
+static int
+compare_one (const char *path, const struct stat *st, int type,
+	     struct FTW *ftw)
+{
+  static char a[1 << 20], b[sizeof a];
+  (void) ftw;
+
+  if (type != FTW_F)
+    return 0;
+  ssize_t n = hostdir_read (path, "", a, sizeof a);
+  ssize_t m = hostdir_read (other_dir, path + root_len, b, sizeof b);
+  differ |= n < 0 || n != st->st_size || n != m || memcmp (a, b, n) != 0;
+  return differ;
+}
+
+int
+hostdir_equal (const char *a, const char *b)
+{
+  if (hostdir_count (a) != hostdir_count (b))
+    return 0;
+  other_dir = b;
+  root_len = strlen (a);
+  differ = 0;
+  nftw (a, compare_one, 16, FTW_PHYS);
+  return !differ;
+}
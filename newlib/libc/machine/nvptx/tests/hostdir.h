@@ -0,0 +1,43 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Directories of the host for the tests of the vramfs unpacker, which
+   can't use the host's file system calls themselves, as vramfs-host.h
+   renames them.  */
+
+#ifndef _NVPTX_HOSTDIR_H_
+#define _NVPTX_HOSTDIR_H_
+
+#include <sys/types.h>
+
+/* A new empty directory, under TMPDIR.  */
+extern const char *hostdir_make (void);
+
+/* Remove DIR with everything in it, and free its name.  */
+extern void hostdir_remove (const char *dir);
+
+/* Read the file PATH (starting with a slash, or empty) below DIR into
+   BUF, of SIZE bytes.  Returns the size of the file, or -1 if it can't
+   be read.  */
+extern ssize_t hostdir_read (const char *dir, const char *path, void *buf,
+			     size_t size);
+
+/* The number of regular files below DIR.  */
+extern int hostdir_count (const char *dir);
+
+/* Whether A and B hold the same regular files with the same contents.  */
+extern int hostdir_equal (const char *a, const char *b);
+
+#endif /* _NVPTX_HOSTDIR_H_ */
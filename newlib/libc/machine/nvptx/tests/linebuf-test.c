@@ -0,0 +1,131 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Host test of the line buffers of putchar and puts, with fewer slots
+   than threads, so that threads keep taking over each other's slots, and
+   some threads exit in the middle of a line.  Output goes to the binary
+   log.  Whatever the records look like, every character a thread wrote
+   must come out exactly once, in the order the thread wrote it.  */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "machine/binlog.h"
+
+extern int __nvptx_line_putc (int);
+extern int __nvptx_line_puts (const char *);
+extern void __nvptx_line_flush (void);
+extern void __nvptx_line_flush_all (void);
+
+#define THREADS 16
+#define CHARS 3000
+
+/* Thread T writes the characters FIRST + 5 * T up to FIRST + 5 * T + 4,
+   and newlines, so that its output can be picked out from the rest.  */
+#define FIRST '!'
+#define THREAD_CHAR(t, i) (FIRST + 5 * (t) + (i) % 5)
+
+static char written[THREADS][CHARS];
+
+static void *
+writer (void *arg)
+{
+  long t = (long) arg;
+  unsigned int seed = t + 1;
+  int n = 0;
+
+  while (n < CHARS)
+    {
+      seed = seed * 1103515245 + 12345;
+      /* Binary logging keeps no more of a string than this.  */
+      int len = (seed >> 16) % NVPTX_LOG_MAX_STRING;
+      if (len > CHARS - n)
+	len = CHARS - n;
+
+      switch ((seed >> 8) % 4)
+	{
+	case 0:
+	  {
+	    char str[NVPTX_LOG_MAX_STRING];
+	    for (int i = 0; i < len; ++i, ++n)
+	      str[i] = written[t][n] = THREAD_CHAR (t, n);
+	    str[len] = '\0';
+	    assert (__nvptx_line_puts (str) >= 0);
+	  }
+	  break;
+	case 1:
+	  /* A partial line that other output must not overtake.  */
+	  for (int i = 0; i < len; ++i, ++n)
+	    assert (__nvptx_line_putc (written[t][n] = THREAD_CHAR (t, n)) >= 0);
+	  __nvptx_line_flush ();
+	  break;
+	default:
+	  for (int i = 0; i < len; ++i, ++n)
+	    assert (__nvptx_line_putc (written[t][n] = THREAD_CHAR (t, n)) >= 0);
+	  if (len % 3)
+	    assert (__nvptx_line_putc ('\n') == '\n');
+	  break;
+	}
+    }
+  /* Odd threads exit in the middle of a line.  */
+  if (t % 2 == 0)
+    assert (__nvptx_line_putc ('\n') == '\n');
+  return NULL;
+}
+
+static const char *
+resolve_direct (unsigned long long addr, void *ctx)
+{
+  (void) ctx;
+  return (const char *) (unsigned long) addr;
+}
+
+int
+main (void)
+{
+  __nvptx_log.enabled = 1;
+
+  pthread_t threads[THREADS];
+  for (long t = 0; t < THREADS; ++t)
+    assert (pthread_create (&threads[t], NULL, writer, (void *) t) == 0);
+  for (int t = 0; t < THREADS; ++t)
+    pthread_join (threads[t], NULL);
+  __nvptx_line_flush_all ();
+  assert (!__nvptx_log.rings[0].dropped);
+
+  char *text;
+  size_t size;
+  FILE *out = open_memstream (&text, &size);
+  assert (__nvptx_log_format (&__nvptx_log, resolve_direct, NULL, out) > 0);
+  fclose (out);
+
+  int n[THREADS] = { 0 };
+  for (size_t i = 0; i < size; ++i)
+    if (text[i] != '\n')
+      {
+	int t = (text[i] - FIRST) / 5;
+	assert (t >= 0 && t < THREADS && n[t] < CHARS);
+	assert (text[i] == written[t][n[t]]);
+	++n[t];
+      }
+  for (int t = 0; t < THREADS; ++t)
+    assert (n[t] == CHARS);
+  free (text);
+
+  puts ("linebuf-test: ok");
+  return 0;
+}
@@ -0,0 +1,195 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Host test of the binary log: records written by __nvptx_log_vprintf
+   from host threads are formatted back by __nvptx_log_format and must
+   match what printf makes of the same format and arguments.  */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "machine/binlog.h"
+
+extern int __nvptx_log_vprintf (const char *, va_list);
+
+#define THREADS 4
+#define RECORDS 100
+
+static char expected[1 << 16];
+static size_t expected_len;
+
+/* Log FMT and append what printf would print to EXPECTED.  */
+
+static void
+log_printf (const char *fmt, ...)
+{
+  va_list args;
+  va_start (args, fmt);
+  assert (__nvptx_log_vprintf (fmt, args) == 0);
+  va_end (args);
+
+  va_start (args, fmt);
+  expected_len += vsnprintf (expected + expected_len,
+			     sizeof expected - expected_len, fmt, args);
+  va_end (args);
+}
+
+/* The host is the device here, so device addresses are host ones.  */
+
+static const char *
+resolve_direct (unsigned long long addr, void *ctx)
+{
+  return (const char *) (uintptr_t) addr;
+}
+
+static char *
+format_all (void)
+{
+  char *text;
+  size_t len;
+  FILE *out = open_memstream (&text, &len);
+  assert (__nvptx_log_format (&__nvptx_log, resolve_direct, NULL, out) >= 0);
+  fclose (out);
+  return text;
+}
+
+static int
+log_only (const char *fmt, ...)
+{
+  va_list args;
+  va_start (args, fmt);
+  int res = __nvptx_log_vprintf (fmt, args);
+  va_end (args);
+  return res;
+}
+
+static void *
+writer (void *arg)
+{
+  long id = (long) arg;
+  for (int i = 0; i < RECORDS; i++)
+    assert (log_only ("thread %ld record %d\n", id, i) == 0);
+  return NULL;
+}
+
+int
+main (void)
+{
+  char *text;
+
+  __nvptx_log.enabled = 1;
+
+  /* Every conversion log_args knows about.  */
+  log_printf ("plain text, 100%% literal\n");
+  log_printf ("%d %i %5d %-5d| %+d %ld %lld %hd\n", -42, 7, 3, 4, 5,
+	      -1234567890123L, 9876543210123LL, (short) -3);
+  log_printf ("%u %o %x %X %#x %08x %lu %zu\n", 4000000000u, 8u, 255u,
+	      255u, 255u, 0xbeefu, 18446744073709551615ul, (size_t) 99);
+  log_printf ("%c%c%c\n", 'a', 'b', 'c');
+  log_printf ("%f %.3f %e %g %10.2f %a\n", 3.25, 1.0 / 3, 12345.678,
+	      0.0001, -2.5, 1.5);
+  log_printf ("%*d|%-*d|%.*f\n", 6, 12, 4, 7, 2, 3.14159);
+  log_printf ("%s and %10s and %-4s| %.3s\n", "one", "two", "x", "abcdef");
+  log_printf ("%p\n", (void *) 0x1234);
+  text = format_all ();
+  if (strcmp (text, expected))
+    {
+      fprintf (stderr, "expected:\n%s\ngot:\n%s\n", expected, text);
+      return 1;
+    }
+  free (text);
+
+  /* Strings are kept up to NVPTX_LOG_MAX_STRING bytes.  */
+  char longstr[300];
+  memset (longstr, 'y', sizeof longstr - 1);
+  longstr[sizeof longstr - 1] = '\0';
+  expected_len = 0;
+  log_printf ("[%s]\n", longstr);
+  text = format_all ();
+  assert (strlen (text) == NVPTX_LOG_MAX_STRING + 3);
+  free (text);
+
+  /* Records from concurrent writers are all there, each writer's in
+     order.  */
+  pthread_t threads[THREADS];
+  for (long i = 0; i < THREADS; i++)
+    pthread_create (&threads[i], NULL, writer, (void *) i);
+  for (int i = 0; i < THREADS; i++)
+    pthread_join (threads[i], NULL);
+  text = format_all ();
+  int next[THREADS] = { 0 };
+  long id;
+  int rec, pos;
+  for (char *line = text; sscanf (line, "thread %ld record %d\n%n", &id,
+				  &rec, &pos) == 2; line += pos)
+    {
+      assert (id >= 0 && id < THREADS && rec == next[id]);
+      next[id]++;
+    }
+  for (int i = 0; i < THREADS; i++)
+    assert (next[i] == RECORDS);
+  free (text);
+
+  /* A full ring drops records and counts them.  */
+  int dropped = 0;
+  for (int i = 0; i < NVPTX_LOG_RING_WORDS; i++)
+    dropped += log_only ("%d\n", i) != 0;
+  assert (dropped && __nvptx_log.rings[0].dropped == (unsigned) dropped);
+  text = format_all ();
+  free (text);
+  assert (__nvptx_log.rings[0].tail == __nvptx_log.rings[0].head);
+
+  /* Once the ring has wrapped, a record that is reserved but not written
+     yet still has the header of the record of the lap before where its
+     own goes.  Records of two words line up with that one exactly.  */
+  unsigned long long *head = &__nvptx_log.rings[0].head;
+  if (*head % 2)
+    assert (log_only ("%d\n", 0) == 0);
+  for (int lap = 0; lap < 3; lap++)
+    {
+      for (int i = 0; i < NVPTX_LOG_RING_WORDS / 4; i++)
+	assert (log_only ("x\n") == 0);
+      text = format_all ();
+      free (text);
+    }
+  assert (*head > NVPTX_LOG_RING_WORDS && *head % 2 == 0);
+  *head += 2;
+  assert (__nvptx_log_format (&__nvptx_log, resolve_direct, NULL, stdout) == 0);
+  *head -= 2;
+
+  /* A host copy of the image's strings, at another address than on the
+     device.  */
+  static const char image[] = "junk\0" NVPTX_LOG_ANCHOR "\0fmt %d\n";
+  struct __nvptx_log_image img;
+  unsigned long long device_anchor = 0x7000;
+  assert (__nvptx_log_image_init (&img, image, sizeof image,
+				  device_anchor) == 0);
+  const char *fmt = __nvptx_log_image_resolve (device_anchor
+					       + sizeof NVPTX_LOG_ANCHOR,
+					       &img);
+  assert (fmt && !strcmp (fmt, "fmt %d\n"));
+  assert (!__nvptx_log_image_resolve (device_anchor + sizeof image, &img));
+  assert (__nvptx_log_image_init (&img, "nothing", 8, 0) == -1);
+
+  /* The anchor is recorded with the first record.  */
+  assert (__nvptx_log.anchor == (uintptr_t) __nvptx_log_anchor);
+
+  puts ("log-test: ok");
+  return 0;
+}
@@ -0,0 +1,146 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Host test of the LZ block codec: inputs of every shape and size up to
+   LZ_MAX_INPUT must come back unchanged, and truncated or undersized
+   buffers must be refused.  Run with the argument "bench" to time
+   compression and decompression of 64 KiB blocks instead.  */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lz.h"
+
+enum { RANDOM, FEW_SYMBOLS, TEXT, RUNS, ZEROS, SHAPES };
+
+static unsigned short table[LZ_WORK_ELEMS];
+static unsigned char src[LZ_MAX_INPUT];
+static unsigned char packed[LZ_BOUND (LZ_MAX_INPUT)];
+static unsigned char out[LZ_MAX_INPUT];
+
+static void
+fill (unsigned char *buf, size_t len, int shape)
+{
+  static const char text[] = "step 17: residual 0.000125 converged\n";
+
+  for (size_t i = 0; i < len; ++i)
+    switch (shape)
+      {
+      case RANDOM: buf[i] = rand (); break;
+      case FEW_SYMBOLS: buf[i] = 'a' + rand () % 3; break;
+      case TEXT: buf[i] = text[i % (sizeof text - 1)]; break;
+      case RUNS: buf[i] = i / 300; break;
+      default: buf[i] = 0; break;
+      }
+}
+
+/* Compress and decompress LEN bytes of SRC, returning the packed size.  */
+
+static size_t
+round_trip (size_t len)
+{
+  size_t n = __nvptx_lz_compress (src, len, packed, LZ_BOUND (len), table);
+  assert (n > 0 && n <= LZ_BOUND (len));
+  assert (__nvptx_lz_decompress (packed, n, out, len) == len);
+  assert (memcmp (src, out, len) == 0);
+  return n;
+}
+
+static double
+seconds (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void
+bench (void)
+{
+  static const char *const names[SHAPES]
+    = { "random", "few-symbols", "text", "runs", "zeros" };
+  const int reps = 200;
+
+  for (int shape = 0; shape < SHAPES; ++shape)
+    {
+      fill (src, LZ_MAX_INPUT, shape);
+      size_t n = 0;
+      double start = seconds ();
+      for (int i = 0; i < reps; ++i)
+	n = __nvptx_lz_compress (src, LZ_MAX_INPUT, packed,
+				 LZ_BOUND (LZ_MAX_INPUT), table);
+      double mid = seconds ();
+      for (int i = 0; i < reps; ++i)
+	__nvptx_lz_decompress (packed, n, out, LZ_MAX_INPUT);
+      double end = seconds ();
+
+      double mb = (double) LZ_MAX_INPUT * reps / 1e6;
+      printf ("%-12s ratio %5.3f  compress %8.1f MB/s  decompress %8.1f MB/s\n",
+	      names[shape], (double) n / LZ_MAX_INPUT, mb / (mid - start),
+	      mb / (end - mid));
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc > 1 && strcmp (argv[1], "bench") == 0)
+    {
+      bench ();
+      return 0;
+    }
+
+  srand (1);
+
+  /* Every shape at the edges of the format: empty, shorter than a
+     match, a single full block.  */
+  static const size_t edges[] = { 0, 1, 3, 4, 5, 15, 16, 255, 270, 4096,
+				  LZ_MAX_INPUT - 1, LZ_MAX_INPUT };
+  for (int shape = 0; shape < SHAPES; ++shape)
+    for (size_t i = 0; i < sizeof edges / sizeof edges[0]; ++i)
+      {
+	fill (src, edges[i], shape);
+	round_trip (edges[i]);
+      }
+
+  for (int i = 0; i < 2000; ++i)
+    {
+      size_t len = rand () % (i % 3 ? LZ_MAX_INPUT + 1 : 64);
+      fill (src, len, i % SHAPES);
+      round_trip (len);
+    }
+
+  /* Repetitive data must actually shrink.  */
+  fill (src, LZ_MAX_INPUT, ZEROS);
+  assert (round_trip (LZ_MAX_INPUT) < LZ_MAX_INPUT / 100);
+  fill (src, LZ_MAX_INPUT, TEXT);
+  assert (round_trip (LZ_MAX_INPUT) < LZ_MAX_INPUT / 10);
+
+  /* A destination that is too small, and truncated or oversized input,
+     are refused rather than overrun.  */
+  fill (src, 4096, FEW_SYMBOLS);
+  size_t n = __nvptx_lz_compress (src, 4096, packed, LZ_BOUND (4096), table);
+  assert (n > 1);
+  assert (__nvptx_lz_compress (src, 4096, packed, n - 1, table) == 0);
+  assert (__nvptx_lz_decompress (packed, n, out, 4095) != 4096);
+  assert (__nvptx_lz_decompress (packed, n - 1, out, 4096) != 4096);
+  assert (__nvptx_lz_compress (src, LZ_MAX_INPUT + 1, packed,
+			       sizeof packed, table) == 0);
+
+  puts ("lz-test: ok");
+  return 0;
+}
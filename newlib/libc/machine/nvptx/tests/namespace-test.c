@@ -0,0 +1,189 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Host test of the sharded vramfs namespace: threads, each a team of its
+   own, create, write, reopen, read and remove files of their own, and
+   list the directory they share, all at once; and only one of them may
+   open a file they all open at once.  Run with the argument
+   "bench" to print the throughput of create/open/close cycles as the
+   number of threads grows; build with -DVRAMFS_SHARDS=N to compare shard
+   counts.  */
+
+#include "vramfs-host.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "sys/dirent.h"
+
+#define MAX_THREADS 16
+
+/* As in misc.c.  */
+#ifndef VRAMFS_SHARDS
+#define VRAMFS_SHARDS 1
+#endif
+
+static int iterations = 2000;
+static int checked = 1;
+
+/* One create/write/close, open/read/close, unlink cycle on a file named
+   after the thread.  */
+
+static void *
+churn (void *arg)
+{
+  int id = (int) (long) arg;
+  char name[32], data[32], back[32];
+  snprintf (name, sizeof name, "/d/t%d", id);
+
+  for (int i = 0; i < iterations; ++i)
+    {
+      int len = snprintf (data, sizeof data, "%d:%d", id, i);
+
+      int fd = open (name, O_WRONLY | O_CREAT | O_TRUNC);
+      assert (fd >= 3);
+      assert (write (fd, data, len) == len);
+      assert (close (fd) == 0);
+
+      fd = open (name, O_RDONLY);
+      assert (fd >= 3);
+      assert (read (fd, back, sizeof back) == len);
+      assert (close (fd) == 0);
+      if (checked)
+	assert (memcmp (data, back, len) == 0);
+
+      assert (unlink (name) == 0);
+    }
+  return NULL;
+}
+
+/* Run churn on NTHREADS threads, returning the elapsed seconds.  */
+
+static double
+run_threads (int nthreads)
+{
+  pthread_t threads[MAX_THREADS];
+  struct timespec start, end;
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (long i = 0; i < nthreads; ++i)
+    assert (pthread_create (&threads[i], NULL, churn, (void *) i) == 0);
+  for (int i = 0; i < nthreads; ++i)
+    pthread_join (threads[i], NULL);
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  return end.tv_sec - start.tv_sec + (end.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+static void *
+list (void *arg)
+{
+  for (int i = 0; i < iterations / 10; ++i)
+    {
+      DIR *dir = opendir ("/d");
+      assert (dir);
+      struct dirent *ent;
+      while ((ent = readdir (dir)))
+	assert (ent->d_name[0] == 't' || ent->d_name[0] == 'k');
+      closedir (dir);
+    }
+  return NULL;
+}
+
+/* Threads open the same file at once; only one may have it open.  */
+
+static pthread_barrier_t barrier;
+static int nopened;
+
+static void *
+open_shared (void *arg)
+{
+  (void) arg;
+  for (int i = 0; i < iterations / 10; ++i)
+    {
+      pthread_barrier_wait (&barrier);
+      int fd = open ("/d/k0", O_RDWR);
+      if (fd >= 0)
+	__atomic_add_fetch (&nopened, 1, __ATOMIC_RELAXED);
+      else
+	assert (errno == EACCES);
+      pthread_barrier_wait (&barrier);
+      if (fd >= 0)
+	assert (close (fd) == 0);
+    }
+  return NULL;
+}
+
+int
+main (int argc, char **argv)
+{
+  assert (mkdir ("/d", 0777) == 0);
+
+  if (argc > 1 && strcmp (argv[1], "bench") == 0)
+    {
+      iterations = 20000;
+      checked = 0;
+      printf ("%d shard(s)\n", VRAMFS_SHARDS);
+      for (int nthreads = 1; nthreads <= MAX_THREADS; nthreads *= 2)
+	{
+	  double secs = run_threads (nthreads);
+	  printf ("%2d threads %10.0f cycles/s\n", nthreads,
+		  nthreads * iterations / secs);
+	}
+      return 0;
+    }
+
+  /* Files that stay put while the others come and go.  */
+  for (int i = 0; i < 4; ++i)
+    {
+      char name[32];
+      snprintf (name, sizeof name, "/d/k%d", i);
+      int fd = open (name, O_WRONLY | O_CREAT | O_TRUNC);
+      assert (fd >= 3 && close (fd) == 0);
+    }
+
+  pthread_t lister;
+  assert (pthread_create (&lister, NULL, list, NULL) == 0);
+  run_threads (MAX_THREADS / 2);
+  pthread_join (lister, NULL);
+
+  /* Nothing leaked: every thread's file is gone, the others are still
+     there, and the slots of the removed ones can all be had again.  */
+  struct stat st;
+  int nfiles = 0;
+  DIR *dir = opendir ("/d");
+  while (readdir (dir))
+    ++nfiles;
+  closedir (dir);
+  assert (nfiles == 4);
+  assert (stat ("/d/t0", &st) == -1 && stat ("/d/k3", &st) == 0);
+  run_threads (MAX_THREADS);
+
+  pthread_t threads[MAX_THREADS];
+  pthread_barrier_init (&barrier, NULL, MAX_THREADS);
+  for (long i = 0; i < MAX_THREADS; ++i)
+    assert (pthread_create (&threads[i], NULL, open_shared, NULL) == 0);
+  for (int i = 0; i < MAX_THREADS; ++i)
+    pthread_join (threads[i], NULL);
+  assert (nopened == iterations / 10);
+
+  puts ("namespace-test: ok");
+  return 0;
+}
@@ -0,0 +1,38 @@
+#!/bin/sh
+# Build and run the host tests of the nvptx support files.  These check the
+# parts of the library that don't need a GPU, with the host compiler:
+#
+#   sh newlib/libc/machine/nvptx/tests/run.sh
+#
+# CC and CFLAGS may be overridden; by default the tests are built with the
+# address and undefined behaviour sanitizers.
+
+set -e
+cd "$(dirname "$0")"
+
+CC=${CC:-cc}
+CFLAGS=${CFLAGS:--g -O1 -Wall -fsanitize=address,undefined}
+OUT=${TMPDIR:-/tmp}/nvptx-host-tests
+mkdir -p "$OUT"
+
+# run NAME SOURCES...
+run ()
+{
+  name=$1
+  shift
+  $CC $CFLAGS -I.. "$@" -lpthread -o "$OUT/$name"
+  "$OUT/$name"
+}
+
+run log-test log-test.c ../log.c
+run linebuf-test -DNVPTX_LINE_SLOTS=4 -DNVPTX_LOG_RING_WORDS=65536 linebuf-test.c ../linebuf.c ../log.c
+run lz-test lz-test.c ../lz.c
+run namespace-test -DVRAMFS_MAX_FILES=256 namespace-test.c vramfs-host.c ../log.c ../lz.c ../stdin.c ../warp.c ../warpwrite.c
+run namespace-test-sharded -DVRAMFS_MAX_FILES=256 -DVRAMFS_SHARDS=8 namespace-test.c vramfs-host.c ../log.c ../lz.c ../stdin.c ../warp.c ../warpwrite.c
+run delta-test -DVRAMFS_MAX_FILES=64 delta-test.c hostdir.c ../unpack.c vramfs-host.c ../log.c ../lz.c ../stdin.c ../warp.c ../warpwrite.c
+run clock-test clock-test.c ../clock.c
+run stdin-test -DVRAMFS_STDIN_SIZE=256 stdin-test.c ../stdin.c
+run warpwrite-test -DNVPTX_WARP_WRITE_SLOTS=2 warpwrite-test.c vramfs-host.c ../log.c ../lz.c ../stdin.c ../warp.c ../warpwrite.c
+run heap-test -fno-builtin -Wl,--wrap=malloc,--wrap=free heap-test.c heap-host.c
+run dedup-test -DVRAMFS_MAX_FILES=64 dedup-test.c vramfs-host.c ../log.c ../lz.c ../stdin.c ../warp.c ../warpwrite.c
+run export-test export-test.c hostdir.c ../unpack.c vramfs-host.c ../log.c ../lz.c ../stdin.c ../warp.c ../warpwrite.c
@@ -0,0 +1,131 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Host test of the stdin ring: a host thread feeds a stream through
+   __vramfs_stdin_push while several threads read it with
+   __nvptx_stdin_read, through a small ring so that it wraps around all
+   the time.  Every byte must be read exactly once, and every read must
+   be a contiguous piece of the stream.  */
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include "machine/vramfs.h"
+
+extern ssize_t __nvptx_stdin_read (void *, size_t);
+
+#define READERS 4
+#define STREAM_LEN (1 << 20)
+
+/* Byte I of the stream.  The period is prime, so it doesn't line up with
+   the ring.  */
+#define STREAM_BYTE(i) ((unsigned char) ((i) % 251))
+
+static unsigned long long counts[READERS][251];
+
+static void *
+reader (void *arg)
+{
+  unsigned long long *count = counts[(long) arg];
+  unsigned char buf[3 * VRAMFS_STDIN_SIZE / 2];
+  ssize_t n;
+
+  while ((n = __nvptx_stdin_read (buf, 1 + rand () % sizeof buf)) > 0)
+    for (ssize_t i = 0; i < n; ++i)
+      {
+	if (i)
+	  assert (buf[i] == (buf[i - 1] + 1) % 251);
+	++count[buf[i]];
+      }
+  assert (n == 0);
+  return NULL;
+}
+
+static void *
+writer (void *arg)
+{
+  static unsigned char stream[STREAM_LEN];
+  for (size_t i = 0; i < STREAM_LEN; ++i)
+    stream[i] = STREAM_BYTE (i);
+
+  for (size_t done = 0; done < STREAM_LEN; )
+    {
+      size_t len = 1 + rand () % (2 * VRAMFS_STDIN_SIZE);
+      if (len > STREAM_LEN - done)
+	len = STREAM_LEN - done;
+      size_t n = __vramfs_stdin_push (&__vramfs_stdin, stream + done, len);
+      if (!n)
+	sched_yield ();
+      done += n;
+    }
+  __atomic_store_n (&__vramfs_stdin.closed, 1, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+int
+main (void)
+{
+  char c;
+
+  /* Not enabled: end of file.  */
+  assert (__nvptx_stdin_read (&c, 1) == 0);
+
+  /* Empty and nonblocking: EAGAIN.  */
+  __vramfs_stdin.enabled = 1;
+  __vramfs_stdin.nonblock = 1;
+  errno = 0;
+  assert (__nvptx_stdin_read (&c, 1) == -1 && errno == EAGAIN);
+  assert (__vramfs_stdin_push (&__vramfs_stdin, "x", 1) == 1);
+  assert (__nvptx_stdin_read (&c, 1) == 1 && c == 'x');
+
+  /* A full ring takes no more.  */
+  static char fill[VRAMFS_STDIN_SIZE + 1];
+  assert (__vramfs_stdin_push (&__vramfs_stdin, fill, sizeof fill)
+	  == VRAMFS_STDIN_SIZE);
+  assert (__vramfs_stdin_push (&__vramfs_stdin, fill, 1) == 0);
+  static char drain[VRAMFS_STDIN_SIZE];
+  assert (__nvptx_stdin_read (drain, sizeof drain) == VRAMFS_STDIN_SIZE);
+
+  /* Blocking readers against a concurrent writer.  */
+  __vramfs_stdin.nonblock = 0;
+  pthread_t threads[READERS + 1];
+  for (long i = 0; i < READERS; ++i)
+    assert (pthread_create (&threads[i], NULL, reader, (void *) i) == 0);
+  assert (pthread_create (&threads[READERS], NULL, writer, NULL) == 0);
+  for (int i = 0; i <= READERS; ++i)
+    pthread_join (threads[i], NULL);
+
+  unsigned long long expected[251] = { 0 };
+  for (size_t i = 0; i < STREAM_LEN; ++i)
+    ++expected[STREAM_BYTE (i)];
+  for (int b = 0; b < 251; ++b)
+    {
+      unsigned long long total = 0;
+      for (int r = 0; r < READERS; ++r)
+	total += counts[r][b];
+      assert (total == expected[b]);
+    }
+
+  /* Closed and drained: end of file, for good.  */
+  assert (__nvptx_stdin_read (&c, 1) == 0);
+
+  puts ("stdin-test: ok");
+  return 0;
+}
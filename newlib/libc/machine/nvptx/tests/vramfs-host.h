@@ -0,0 +1,53 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Host tests build misc.c (through vramfs-host.c) next to the host's C
+   library, so its system calls are renamed from open to vramfs_open and
+   so on.  Include this first, in the test and in vramfs-host.c alike.  */
+
+#ifndef _NVPTX_VRAMFS_HOST_H_
+#define _NVPTX_VRAMFS_HOST_H_
+
+/* The fortified wrappers of the host's headers would call the host's
+   system calls.  */
+#undef _FORTIFY_SOURCE
+
+#define close vramfs_close
+#define fstat vramfs_fstat
+#define getpid vramfs_getpid
+#define isatty vramfs_isatty
+#define kill vramfs_kill
+#define lseek vramfs_lseek
+#define open vramfs_open
+#define read vramfs_read
+#define write vramfs_write
+#define stat vramfs_stat
+#define sync vramfs_sync
+#define unlink vramfs_unlink
+#define link vramfs_link
+#define rename vramfs_rename
+#define ftruncate vramfs_ftruncate
+#define truncate vramfs_truncate
+#define posix_fallocate vramfs_posix_fallocate
+#define mkdir vramfs_mkdir
+#define rmdir vramfs_rmdir
+#define opendir vramfs_opendir
+#define readdir vramfs_readdir
+#define rewinddir vramfs_rewinddir
+#define closedir vramfs_closedir
+#define copy_file_range vramfs_copy_file_range
+#define sendfile vramfs_sendfile
+
+#endif /* _NVPTX_VRAMFS_HOST_H_ */
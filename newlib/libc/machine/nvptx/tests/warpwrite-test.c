@@ -0,0 +1,326 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Host test of combined warp writes: host threads joined to emulated
+   warps stand in for lanes.  Lanes that write together must come out as
+   one write in lane order, with each lane getting its share of a short
+   write; lanes that can't take part, or whose write fails, must be told
+   to write on their own.  Through vramfs, the lanes' writes to a shared
+   file must end up in lane order.  Run with the argument "bench" to time
+   combined writes against lanes writing one after the other, and count
+   the calls each makes to the writer.  The emulated warp primitives cost
+   far more than the hardware ones, so on the host the combined writes
+   come out slower; the numbers are for comparing versions of
+   warpwrite.c, not for predicting the device.  */
+
+#include "vramfs-host.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "machine/vramfs.h"
+#include "warp.h"
+#include "warpwrite.h"
+
+#define WARPS 4
+#define ROUNDS 200
+
+/* Where a group's writes go.  LIMIT cuts writes short, and a negative
+   one makes them fail.  */
+
+struct sink
+{
+  pthread_mutex_t lock;
+  char data[2 * WARP_SIZE * NVPTX_WARP_WRITE_MAX];
+  size_t size;
+  long limit;
+  int calls;
+};
+
+static struct __nvptx_warp_emu warps[WARPS];
+static struct sink sinks[WARPS][2];
+static int file_fd;
+
+static int
+sink_write (void *ctx, const void *buf, size_t count, ssize_t *new_count_ref)
+{
+  struct sink *sink = ctx;
+  if (sink->limit < 0)
+    return -1;
+  if (sink->limit && count > (size_t) sink->limit)
+    count = sink->limit;
+
+  pthread_mutex_lock (&sink->lock);
+  memcpy (sink->data + sink->size, buf, count);
+  sink->size += count;
+  sink->calls++;
+  pthread_mutex_unlock (&sink->lock);
+  *new_count_ref = count;
+  return 0;
+}
+
+static void
+sink_reset (struct sink *sink, long limit)
+{
+  sink->size = 0;
+  sink->limit = limit;
+  sink->calls = 0;
+}
+
+/* What LANE writes in round ROUND: LEN bytes of its own pattern.  */
+
+static size_t
+lane_data (char *buf, unsigned int lane, int round, size_t len)
+{
+  for (size_t i = 0; i < len; ++i)
+    buf[i] = 'A' + (lane + round + i) % 26;
+  return len;
+}
+
+/* The lanes' writes of round ROUND, as SINK should have them, from lane
+   FIRST on, every STEP lanes.  */
+
+static void
+check_sink (const struct sink *sink, int round, unsigned int first,
+	    unsigned int step, const size_t *lens)
+{
+  char want[NVPTX_WARP_WRITE_MAX];
+  size_t at = 0;
+  for (unsigned int lane = first; lane < WARP_SIZE; lane += step)
+    {
+      lane_data (want, lane, round, lens[lane]);
+      assert (memcmp (sink->data + at, want, lens[lane]) == 0);
+      at += lens[lane];
+    }
+  assert (at == sink->size && sink->calls == 1);
+}
+
+static size_t lens[WARPS][WARP_SIZE];
+static int results[WARPS][WARP_SIZE];
+static ssize_t counts[WARPS][WARP_SIZE];
+
+static void *
+lane_main (void *arg)
+{
+  long id = (long) arg;
+  int w = id / WARP_SIZE;
+  unsigned int lane = id % WARP_SIZE;
+  struct sink *sink = sinks[w];
+  char buf[NVPTX_WARP_WRITE_MAX + 1];
+
+  __nvptx_warp_emu_join (&warps[w], lane);
+  unsigned int mask = warp_active_mask ();
+
+  for (int round = 0; round < ROUNDS; ++round)
+    {
+      int shape = round % 5;
+      size_t len = rand () % (round % 2 ? 64 : NVPTX_WARP_WRITE_MAX + 1);
+      if (lane == 0)
+	{
+	  sink_reset (&sink[0], shape == 3 ? 10 * 20 : shape == 4 ? -1 : 0);
+	  sink_reset (&sink[1], 0);
+	}
+      if (shape == 2 && lane % 4 == 1)
+	len = NVPTX_WARP_WRITE_MAX + 1;
+      if (shape == 3)
+	len = 20;
+      lens[w][lane] = len;
+      lane_data (buf, lane, round, len);
+      warp_sync (mask);
+
+      /* 0: the whole warp together; 1: odd and even lanes apart;
+	 2: some lanes' buffers too large; 3: a short write; 4: an error.  */
+      int key = shape == 1 ? lane % 2 : 0;
+      counts[w][lane] = -1;
+      results[w][lane] = __nvptx_warp_write (key, buf, len, sink_write,
+					     &sink[key], &counts[w][lane]);
+      warp_sync (mask);
+
+      if (lane == 0)
+	for (unsigned int i = 0; i < WARP_SIZE; ++i)
+	  switch (shape)
+	    {
+	    case 0:
+	    case 1:
+	      assert (results[w][i] == 0 && counts[w][i] == (ssize_t) lens[w][i]);
+	      break;
+	    case 2:
+	      assert (results[w][i] == (i % 4 == 1 ? -1 : 0));
+	      assert (i % 4 == 1 || counts[w][i] == (ssize_t) lens[w][i]);
+	      break;
+	    case 3:
+	      /* The first ten lanes' bytes got written.  */
+	      assert (results[w][i] == 0 && counts[w][i] == (i < 10 ? 20 : 0));
+	      break;
+	    case 4:
+	      assert (results[w][i] == -1);
+	      break;
+	    }
+
+      if (lane == 0)
+	switch (shape)
+	  {
+	  case 0:
+	    check_sink (&sink[0], round, 0, 1, lens[w]);
+	    break;
+	  case 1:
+	    check_sink (&sink[0], round, 0, 2, lens[w]);
+	    check_sink (&sink[1], round, 1, 2, lens[w]);
+	    break;
+	  case 2:
+	    {
+	      size_t saved = lens[w][1];
+	      for (unsigned int i = 1; i < WARP_SIZE; i += 4)
+		lens[w][i] = 0;
+	      check_sink (&sink[0], round, 0, 1, lens[w]);
+	      lens[w][1] = saved;
+	    }
+	    break;
+	  }
+      warp_sync (mask);
+    }
+  return NULL;
+}
+
+/* Each lane writes a line to FD, ROUNDS times.  */
+
+static void *
+file_lane (void *arg)
+{
+  long lane = (long) arg;
+  char line[32];
+
+  __nvptx_warp_emu_join (&warps[0], lane);
+  for (int round = 0; round < ROUNDS; ++round)
+    {
+      int len = snprintf (line, sizeof line, "%d.%02ld\n", round, lane);
+      assert (write (file_fd, line, len) == len);
+    }
+  return NULL;
+}
+
+static void
+run_lanes (int nwarps, void *(*fn) (void *))
+{
+  pthread_t threads[WARPS * WARP_SIZE];
+
+  memset (warps, 0, sizeof warps);
+  for (int w = 0; w < nwarps; ++w)
+    warps[w].lanes = ~0u;
+  for (long i = 0; i < nwarps * WARP_SIZE; ++i)
+    assert (pthread_create (&threads[i], NULL, fn, (void *) i) == 0);
+  for (int i = 0; i < nwarps * WARP_SIZE; ++i)
+    pthread_join (threads[i], NULL);
+}
+
+static int bench_combined;
+
+static void *
+bench_lane (void *arg)
+{
+  long id = (long) arg;
+  unsigned int lane = id % WARP_SIZE;
+  struct sink *sink = &sinks[id / WARP_SIZE][0];
+  char buf[64];
+  ssize_t n;
+
+  __nvptx_warp_emu_join (&warps[id / WARP_SIZE], lane);
+  lane_data (buf, lane, 0, sizeof buf);
+  for (int round = 0; round < 20 * ROUNDS; ++round)
+    {
+      if (lane == 0)
+	sink_reset (sink, 0);
+      warp_sync (warp_active_mask ());
+      if (!bench_combined
+	  || __nvptx_warp_write (0, buf, sizeof buf, sink_write, sink, &n))
+	sink_write (sink, buf, sizeof buf, &n);
+      warp_sync (warp_active_mask ());
+    }
+  return NULL;
+}
+
+static void
+bench (void)
+{
+  for (bench_combined = 0; bench_combined < 2; ++bench_combined)
+    {
+      int calls = 0;
+      struct timespec start, end;
+      clock_gettime (CLOCK_MONOTONIC, &start);
+      run_lanes (WARPS, bench_lane);
+      clock_gettime (CLOCK_MONOTONIC, &end);
+      for (int w = 0; w < WARPS; ++w)
+	calls += sinks[w][0].calls;
+      double secs = end.tv_sec - start.tv_sec
+		    + (end.tv_nsec - start.tv_nsec) * 1e-9;
+      printf ("%-9s %10.0f writes/s %5.1f calls per warp's writes\n",
+	      bench_combined ? "combined" : "separate",
+	      WARPS * WARP_SIZE * 20 * ROUNDS / secs, (double) calls / WARPS);
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  for (int w = 0; w < WARPS; ++w)
+    for (int k = 0; k < 2; ++k)
+      pthread_mutex_init (&sinks[w][k].lock, NULL);
+
+  if (argc > 1 && strcmp (argv[1], "bench") == 0)
+    {
+      bench ();
+      return 0;
+    }
+
+  /* A lone thread is a warp of its own.  */
+  ssize_t n;
+  assert (__nvptx_warp_write (0, "x", 1, sink_write, &sinks[0][0], &n) == -1);
+
+  /* Several warps at once, more than there are staging areas, so that
+     some find theirs taken.  */
+  srand (1);
+  run_lanes (WARPS, lane_main);
+
+  /* Lanes writing to a file through vramfs, from a table of descriptors
+     all threads share.  */
+  __vramfs_shared_fds = 1;
+  file_fd = open ("/out", O_WRONLY | O_CREAT | O_TRUNC);
+  assert (file_fd >= 0);
+  run_lanes (1, file_lane);
+  assert (close (file_fd) == 0);
+
+  static char text[ROUNDS * WARP_SIZE * 8];
+  int fd = open ("/out", O_RDONLY);
+  ssize_t size = read (fd, text, sizeof text);
+  assert (size > 0 && (size_t) size < sizeof text && close (fd) == 0);
+  char *p = text;
+  for (int round = 0; round < ROUNDS; ++round)
+    for (int lane = 0; lane < WARP_SIZE; ++lane)
+      {
+	char line[32];
+	int len = snprintf (line, sizeof line, "%d.%02d\n", round, lane);
+	assert (memcmp (p, line, len) == 0);
+	p += len;
+      }
+  assert (p == text + size);
+
+  puts ("warpwrite-test: ok");
+  return 0;
+}
@@ -0,0 +1,278 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Host-side unpacking of the blobs of __vramfs_export into a directory of
+   the host, and applying those of __vramfs_delta to it, for tools that
+   copy them off the device.  Like the log formatter in log.c, nothing in
+   here is built for the device.  The blob formats are described in
+   machine/vramfs.h.
+
+   Paths in a blob are taken relative to the target directory.  A path
+   that isn't absolute or has "." or ".." components is refused, so a blob
+   can't write outside of the directory.  */
+
+#ifndef __nvptx__
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "machine/vramfs.h"
+
+/* The unread part of a blob.  */
+
+struct cursor
+{
+  const char *p;
+  const char *end;
+};
+
+/* Take SIZE bytes, padded to a multiple of 8, off C.  Returns them, or
+   NULL if the blob is too short.  */
+
+static const void *
+take (struct cursor *c, size_t size)
+{
+  const char *p = c->p;
+  size_t padded = (size + 7) & ~(size_t) 7;
+
+  if (padded < size || (size_t) (c->end - p) < padded)
+    return NULL;
+  c->p += padded;
+  return p;
+}
+
+/* Take a path of LEN bytes off C and make it FULL, under DIR.  Returns 0,
+   or -1 if it isn't a path that may be written.  */
+
+static int
+take_path (struct cursor *c, size_t len, const char *dir, char *full)
+{
+  const char *path = take (c, len + 1);
+
+  if (!path || path[len] != '\0' || strlen (path) != len || path[0] != '/')
+    return -1;
+  for (const char *s = path; *s; )
+    {
+      const char *name = ++s;
+      s += strcspn (s, "/");
+      if (s - name == 0 || (s - name == 1 && name[0] == '.')
+	  || (s - name == 2 && name[0] == '.' && name[1] == '.'))
+	return -1;
+    }
+
+  if ((size_t) snprintf (full, PATH_MAX, "%s%s", dir, path) >= PATH_MAX)
+    return -1;
+  return 0;
+}
+
+/* Create the directories leading up to FULL that are below DIR.  */
+
+static int
+make_parents (const char *dir, char *full)
+{
+  for (char *s = full + strlen (dir) + 1; (s = strchr (s, '/')); ++s)
+    {
+      *s = '\0';
+      int res = mkdir (full, 0777);
+      *s = '/';
+      if (res != 0 && errno != EEXIST)
+	return -1;
+    }
+  return 0;
+}
+
+/* Remove FULL with everything below it, if it exists.  With CONTENTS_ONLY,
+   a directory itself stays.  */
+
+static int
+remove_tree (const char *full, int contents_only)
+{
+  struct stat st;
+
+  if (lstat (full, &st) != 0)
+    return errno == ENOENT ? 0 : -1;
+  if (!S_ISDIR (st.st_mode))
+    return unlink (full);
+
+  DIR *d = opendir (full);
+  if (!d)
+    return -1;
+  struct dirent *ent;
+  int res = 0;
+  while (!res && (ent = readdir (d)))
+    {
+      char sub[PATH_MAX];
+      if (!strcmp (ent->d_name, ".") || !strcmp (ent->d_name, ".."))
+	continue;
+      if ((size_t) snprintf (sub, sizeof sub, "%s/%s", full, ent->d_name)
+	  >= sizeof sub)
+	{
+	  errno = ENAMETOOLONG;
+	  res = -1;
+	}
+      else
+	res = remove_tree (sub, 0);
+    }
+  closedir (d);
+  if (res || contents_only)
+    return res;
+  return rmdir (full);
+}
+
+static int
+write_all (int fd, const char *data, size_t size, off_t offset)
+{
+  while (size)
+    {
+      ssize_t n = pwrite (fd, data, size, offset);
+      if (n < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  return -1;
+	}
+      data += n;
+      size -= n;
+      offset += n;
+    }
+  return 0;
+}
+
+/* Set C to the TOTAL_SIZE bytes of the blob at BLOB, of which SIZE bytes
+   are there, and take its header of HEADER_SIZE bytes off.  */
+
+static int
+start (struct cursor *c, const void *blob, size_t size,
+       unsigned long long total_size, size_t header_size)
+{
+  if (total_size > size)
+    return -1;
+  c->p = blob;
+  c->end = c->p + total_size;
+  return take (c, header_size) ? 0 : -1;
+}
+
+int
+__vramfs_unpack (const void *blob, size_t size, const char *dir)
+{
+  const struct __vramfs_export_header *header = blob;
+  struct cursor c;
+  if (size < sizeof *header || header->magic != VRAMFS_EXPORT_MAGIC
+      || header->version != VRAMFS_EXPORT_VERSION
+      || start (&c, blob, size, header->total_size, sizeof *header))
+    goto invalid;
+
+  for (unsigned int i = 0; i < header->nentries; ++i)
+    {
+      char full[PATH_MAX];
+      const struct __vramfs_export_entry *rec = take (&c, sizeof *rec);
+      if (!rec || take_path (&c, rec->name_len, dir, full))
+	goto invalid;
+      const char *data = take (&c, rec->size);
+      if (!data)
+	goto invalid;
+
+      if (make_parents (dir, full))
+	return -1;
+      int fd = open (full, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+      if (fd < 0)
+	return -1;
+      int res = write_all (fd, data, rec->size, 0);
+      if (close (fd) != 0 || res)
+	return -1;
+    }
+  return 0;
+
+ invalid:
+  errno = EINVAL;
+  return -1;
+}
+
+int
+__vramfs_apply_delta (const void *blob, size_t size, const char *dir)
+{
+  const struct __vramfs_delta_header *header = blob;
+  struct cursor c;
+  if (size < sizeof *header || header->magic != VRAMFS_DELTA_MAGIC
+      || header->version != VRAMFS_DELTA_VERSION
+      || start (&c, blob, size, header->total_size, sizeof *header))
+    goto invalid;
+
+  if (header->flags & VRAMFS_DELTA_RESYNC && remove_tree (dir, 1))
+    return -1;
+
+  for (unsigned int i = 0; i < header->nremovals; ++i)
+    {
+      char full[PATH_MAX];
+      const struct __vramfs_delta_removal *rec = take (&c, sizeof *rec);
+      if (!rec || take_path (&c, rec->name_len, dir, full))
+	goto invalid;
+      if (remove_tree (full, 0))
+	return -1;
+    }
+
+  for (unsigned int i = 0; i < header->nentries; ++i)
+    {
+      char full[PATH_MAX];
+      const struct __vramfs_delta_entry *rec = take (&c, sizeof *rec);
+      if (!rec || take_path (&c, rec->name_len, dir, full))
+	goto invalid;
+
+      /* The ranges and their data, all within the file.  */
+      const struct __vramfs_delta_range *ranges = NULL;
+      if (rec->nranges <= (size_t) (c.end - c.p) / sizeof *ranges)
+	ranges = take (&c, rec->nranges * sizeof *ranges);
+      if (!ranges)
+	goto invalid;
+      unsigned long long data_size = 0;
+      for (unsigned int k = 0; k < rec->nranges; ++k)
+	{
+	  if (ranges[k].offset > rec->size
+	      || ranges[k].length > rec->size - ranges[k].offset
+	      || ranges[k].length > ~0ull - data_size)
+	    goto invalid;
+	  data_size += ranges[k].length;
+	}
+      const char *data = take (&c, data_size);
+      if (!data)
+	goto invalid;
+
+      if (make_parents (dir, full))
+	return -1;
+      int fd = open (full, O_WRONLY | O_CREAT, 0666);
+      if (fd < 0)
+	return -1;
+      int res = ftruncate (fd, rec->size);
+      for (unsigned int k = 0; !res && k < rec->nranges; ++k)
+	{
+	  res = write_all (fd, data, ranges[k].length, ranges[k].offset);
+	  data += ranges[k].length;
+	}
+      if (close (fd) != 0 || res)
+	return -1;
+    }
+  return 0;
+
+ invalid:
+  errno = EINVAL;
+  return -1;
+}
+
+#endif /* !__nvptx__ */
@@ -0,0 +1,123 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Host emulation of the warp primitives of warp.h, for testing code that
+   uses them without a GPU.  Nothing in here is built for the device.
+
+   Each collective operation among the lanes of a mask waits at a barrier
+   until all of them have arrived.  Disjoint groups of lanes (as split up
+   by warp_match) run their operations independently, and lanes that are
+   done with their group may already wait for the whole warp, so there is
+   a barrier for every mask, claimed on first use.  Values are exchanged
+   through one slot per lane: a lane publishes its value and waits at the
+   barrier, reads the slots it wants, and waits at the barrier again
+   before its slot can be reused.  */
+
+#ifndef __nvptx__
+
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "warp.h"
+
+static __thread struct __nvptx_warp_emu *emu_warp;
+static __thread unsigned int emu_lane;
+
+/* Make the calling thread lane LANE of WARP.  */
+
+void
+__nvptx_warp_emu_join (struct __nvptx_warp_emu *warp, unsigned int lane)
+{
+  emu_warp = warp;
+  emu_lane = lane;
+}
+
+unsigned int
+__nvptx_warp_emu_lane (void)
+{
+  return emu_warp ? emu_lane : 0;
+}
+
+unsigned int
+__nvptx_warp_emu_mask (void)
+{
+  return emu_warp ? emu_warp->lanes : 1;
+}
+
+/* Emulated warps are told apart by where they are; threads that haven't
+   joined one all share 0, which is fine as they never cooperate.  */
+
+unsigned int
+__nvptx_warp_emu_id (void)
+{
+  return emu_warp ? (uintptr_t) emu_warp / sizeof *emu_warp : 0;
+}
+
+void
+__nvptx_warp_emu_barrier (unsigned int mask)
+{
+  if (!emu_warp || !(mask & (mask - 1)))
+    return;
+
+  unsigned int i;
+  for (i = 0; i < WARP_EMU_BARRIERS; i++)
+    {
+      unsigned int *key = &emu_warp->barriers[i].mask;
+      unsigned int expected = 0;
+      if (__atomic_load_n (key, __ATOMIC_ACQUIRE) == mask
+	  || __atomic_compare_exchange_n (key, &expected, mask, 0,
+					  __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+	  || expected == mask)
+	break;
+    }
+  if (i == WARP_EMU_BARRIERS)
+    abort ();
+
+  unsigned int n = __builtin_popcount (mask);
+  unsigned int *arrived = &emu_warp->barriers[i].arrived;
+  unsigned int *generation = &emu_warp->barriers[i].generation;
+  unsigned int gen = __atomic_load_n (generation, __ATOMIC_ACQUIRE);
+
+  if (__atomic_add_fetch (arrived, 1, __ATOMIC_ACQ_REL) == n)
+    {
+      __atomic_store_n (arrived, 0, __ATOMIC_RELAXED);
+      __atomic_store_n (generation, gen + 1, __ATOMIC_RELEASE);
+      return;
+    }
+  while (__atomic_load_n (generation, __ATOMIC_ACQUIRE) == gen)
+    sched_yield ();
+}
+
+/* Publish VALUE and return the slots of all lanes, once all lanes of MASK
+   have published theirs.  The caller has to wait at the barrier of MASK
+   once it's done reading them.  */
+
+unsigned long long *
+__nvptx_warp_emu_exchange (unsigned int mask, unsigned long long value)
+{
+  static __thread unsigned long long own[WARP_SIZE];
+
+  if (!emu_warp)
+    {
+      own[0] = value;
+      return own;
+    }
+
+  emu_warp->values[emu_lane] = value;
+  __nvptx_warp_emu_barrier (mask);
+  return emu_warp->values;
+}
+
+#endif /* !__nvptx__ */
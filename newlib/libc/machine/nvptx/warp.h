@@ -0,0 +1,200 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Warp-level primitives: the lanes of the calling warp that are active,
+   which of them hold the same value, and exchanging values between them,
+   plus a number that tells the warp apart from the others running.
+
+   Targets with independent thread scheduling (sm_70 and up) use the .sync
+   forms of the PTX instructions.  Below that, every thread acts as a warp
+   of its own, so callers never find other lanes to cooperate with.
+
+   On the host, the primitives are emulated (see warp.c), so code built on
+   them can be tested with host threads standing in for lanes: a thread
+   that has called __nvptx_warp_emu_join is a lane of that emulated warp,
+   and every lane of the warp is taken to be active.  Other threads act as
+   a warp of their own, as on old targets.  */
+
+#ifndef _NVPTX_WARP_H_
+#define _NVPTX_WARP_H_
+
+#define WARP_SIZE 32
+
+#ifdef __nvptx__
+
+static inline unsigned int
+warp_lane (void)
+{
+  unsigned int lane;
+  asm volatile ("mov.u32 %0, %%laneid;" : "=r" (lane));
+  return lane;
+}
+
+/* The hardware slot of the calling warp, unique among the warps resident
+   on the device at the moment.  */
+
+static inline unsigned int
+warp_id (void)
+{
+  unsigned int smid, nwarpid, warpid;
+  asm ("mov.u32 %0, %%smid;" : "=r" (smid));
+  asm ("mov.u32 %0, %%nwarpid;" : "=r" (nwarpid));
+  asm volatile ("mov.u32 %0, %%warpid;" : "=r" (warpid));
+  return smid * nwarpid + warpid;
+}
+
+#if __PTX_SM__ >= 700
+static inline unsigned int
+warp_active_mask (void)
+{
+  unsigned int mask;
+  asm volatile ("activemask.b32 %0;" : "=r" (mask));
+  return mask;
+}
+
+/* The lanes of MASK, all of which must call this, whose VALUE is the same
+   as that of the calling lane.  */
+
+static inline unsigned int
+warp_match (unsigned int mask, int value)
+{
+  unsigned int lanes;
+  asm volatile ("match.any.sync.b32 %0, %1, %2;"
+		: "=r" (lanes) : "r" (value), "r" (mask));
+  return lanes;
+}
+
+/* The VALUE of lane SRC; all lanes of MASK must call this.  */
+
+static inline unsigned long long
+warp_shfl (unsigned int mask, unsigned long long value, unsigned int src)
+{
+  unsigned int lo = value, hi = value >> 32;
+  asm volatile ("shfl.sync.idx.b32 %0, %0, %1, 31, %2;"
+		: "+r" (lo) : "r" (src), "r" (mask));
+  asm volatile ("shfl.sync.idx.b32 %0, %0, %1, 31, %2;"
+		: "+r" (hi) : "r" (src), "r" (mask));
+  return (unsigned long long) hi << 32 | lo;
+}
+
+/* Wait for all lanes of MASK, after which each of them sees the memory
+   writes the others made before.  */
+
+static inline void
+warp_sync (unsigned int mask)
+{
+  asm volatile ("bar.warp.sync %0;" :: "r" (mask) : "memory");
+}
+#else
+static inline unsigned int
+warp_active_mask (void)
+{
+  return 1u << warp_lane ();
+}
+
+static inline unsigned int
+warp_match (unsigned int mask, int value)
+{
+  return mask;
+}
+
+static inline unsigned long long
+warp_shfl (unsigned int mask, unsigned long long value, unsigned int src)
+{
+  return value;
+}
+
+static inline void
+warp_sync (unsigned int mask)
+{
+}
+#endif
+
+#else /* !__nvptx__ */
+
+/* Distinct lane masks an emulated warp can synchronize on.  */
+#define WARP_EMU_BARRIERS 64
+
+/* An emulated warp.  Zero-initialize it and set lanes to the lanes that
+   will join it before any of them does.  */
+
+struct __nvptx_warp_emu
+{
+  unsigned int lanes;
+  unsigned int reserved;
+  unsigned long long values[WARP_SIZE];
+  struct
+  {
+    unsigned int mask;
+    unsigned int arrived;
+    unsigned int generation;
+  } barriers[WARP_EMU_BARRIERS];
+};
+
+extern void __nvptx_warp_emu_join (struct __nvptx_warp_emu *, unsigned int);
+extern unsigned int __nvptx_warp_emu_lane (void);
+extern unsigned int __nvptx_warp_emu_mask (void);
+extern unsigned int __nvptx_warp_emu_id (void);
+extern void __nvptx_warp_emu_barrier (unsigned int);
+extern unsigned long long *__nvptx_warp_emu_exchange (unsigned int,
+						      unsigned long long);
+
+static inline unsigned int
+warp_lane (void)
+{
+  return __nvptx_warp_emu_lane ();
+}
+
+static inline unsigned int
+warp_active_mask (void)
+{
+  return __nvptx_warp_emu_mask ();
+}
+
+static inline unsigned int
+warp_id (void)
+{
+  return __nvptx_warp_emu_id ();
+}
+
+static inline unsigned int
+warp_match (unsigned int mask, int value)
+{
+  unsigned long long *values = __nvptx_warp_emu_exchange (mask, value);
+  unsigned int lanes = 0;
+  for (unsigned int i = 0; i < WARP_SIZE; i++)
+    if (mask >> i & 1 && (int) values[i] == value)
+      lanes |= 1u << i;
+  __nvptx_warp_emu_barrier (mask);
+  return lanes;
+}
+
+static inline unsigned long long
+warp_shfl (unsigned int mask, unsigned long long value, unsigned int src)
+{
+  value = __nvptx_warp_emu_exchange (mask, value)[src];
+  __nvptx_warp_emu_barrier (mask);
+  return value;
+}
+
+static inline void
+warp_sync (unsigned int mask)
+{
+  __nvptx_warp_emu_barrier (mask);
+}
+
+#endif /* !__nvptx__ */
+
+#endif /* _NVPTX_WARP_H_ */
@@ -0,0 +1,146 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Combining the writes of the lanes of a warp.
+
+   When the lanes of a warp write to the same place at the same time, as
+   when they all print a line, writing one after the other costs a call
+   each and lets other output get in between.  Instead, the lanes copy
+   their buffers into one staging buffer in lane order, and the lowest of
+   them writes it with a single call.  Each lane gets its share of the
+   result, so the outcome is that of the lanes writing one after the other
+   in lane order.
+
+   The staging buffer is the warp's staging area, picked by warp_id, which
+   the writing group holds for the duration.  Only a group that needs more
+   than the area holds, or that finds it taken (by another group of its
+   warp, or a warp elsewhere on the device that maps to the same area),
+   allocates one.  This uses only the primitives of warp.h, so it can be
+   built and exercised on the host.  */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "warp.h"
+#include "warpwrite.h"
+
+struct staging
+{
+  int busy;
+  char buf[NVPTX_WARP_WRITE_STAGING];
+};
+
+static struct staging staging_areas[NVPTX_WARP_WRITE_SLOTS];
+
+/* A staging buffer of SIZE bytes for the calling warp, or NULL.  */
+
+static char *
+staging_get (size_t size)
+{
+  struct staging *area = &staging_areas[warp_id () % NVPTX_WARP_WRITE_SLOTS];
+
+  if (size <= NVPTX_WARP_WRITE_STAGING
+      && !__atomic_exchange_n (&area->busy, 1, __ATOMIC_ACQUIRE))
+    return area->buf;
+  return malloc (size);
+}
+
+/* Give back BUF, from staging_get.  The area is told by BUF rather than
+   by warp_id, which may have changed since if the warp was rescheduled.  */
+
+static void
+staging_put (char *buf)
+{
+  for (int i = 0; i < NVPTX_WARP_WRITE_SLOTS; i++)
+    if (buf == staging_areas[i].buf)
+      {
+	__atomic_store_n (&staging_areas[i].busy, 0, __ATOMIC_RELEASE);
+	return;
+      }
+  free (buf);
+}
+
+/* Combines the write of COUNT bytes of BUF by the calling lane with those
+   of the other active lanes of its warp that pass the same KEY; lanes
+   with a negative KEY keep out.  All active lanes have to call this
+   together.  The lowest of these lanes writes them all by calling WRITE
+   with its CTX.  Returns 0 with *NEW_COUNT_REF set to the
+   calling lane's share of the bytes written, or -1 if the write wasn't
+   combined, in which case the caller has to write on its own.  That
+   includes WRITE failing: every lane then tries again on its own, and
+   gets its own error.  */
+
+int
+__nvptx_warp_write (int key, const void *buf, size_t count,
+		    __nvptx_warp_write_fn *write, void *ctx,
+		    ssize_t *new_count_ref)
+{
+  unsigned int mask = warp_active_mask ();
+  if (!(mask & (mask - 1)))
+    return -1;
+
+  /* Lanes whose buffer can't be copied keep out of it.  */
+  if (!buf || count > NVPTX_WARP_WRITE_MAX)
+    key = -1;
+  unsigned int group = warp_match (mask, key);
+  if (key < 0 || !(group & (group - 1)))
+    return -1;
+
+  unsigned int lane = warp_lane ();
+  unsigned int leader = __builtin_ctz (group);
+  size_t offset = 0, total = 0;
+  for (unsigned int lanes = group; lanes; lanes &= lanes - 1)
+    {
+      unsigned int src = __builtin_ctz (lanes);
+      size_t n = warp_shfl (group, count, src);
+      if (src < lane)
+	offset += n;
+      total += n;
+    }
+  if (!total)
+    return -1;
+
+  char *staging = NULL;
+  if (lane == leader)
+    staging = staging_get (total);
+  staging = (char *) (uintptr_t) warp_shfl (group, (uintptr_t) staging,
+					    leader);
+  if (!staging)
+    return -1;
+
+  memcpy (staging + offset, buf, count);
+  warp_sync (group);
+
+  ssize_t new_count = 0;
+  int err = 0;
+  if (lane == leader)
+    {
+      err = write (ctx, staging, total, &new_count);
+      staging_put (staging);
+    }
+
+  err = (int) warp_shfl (group, err, leader);
+  new_count = (ssize_t) warp_shfl (group, new_count, leader);
+  if (err)
+    return -1;
+
+  if ((size_t) new_count <= offset)
+    *new_count_ref = 0;
+  else if ((size_t) new_count - offset < count)
+    *new_count_ref = (size_t) new_count - offset;
+  else
+    *new_count_ref = count;
+  return 0;
+}
@@ -0,0 +1,49 @@
+/*
+ * Support file for nvptx in newlib.
+ * Copyright (c) 2025-Present Arijit Kumar Das <arijitkdgit.official@gmail.com>.
+ *
+ * The authors hereby grant permission to use, copy, modify, distribute,
+ * and license this software and its documentation for any purpose, provided
+ * that existing copyright notices are retained in all copies and that this
+ * notice is included verbatim in any distributions. No written agreement,
+ * license, or royalty fee is required for any of the authorized uses.
+ * Modifications to this software may be copyrighted by their authors
+ * and need not follow the licensing terms described here, provided that
+ * the new terms are clearly indicated on the first page of each file where
+ * they apply.
+ */
+
+/* Internal interface of combined warp writes, used by vramfs' write; see
+   warpwrite.c.  */
+
+#ifndef _NVPTX_WARPWRITE_H_
+#define _NVPTX_WARPWRITE_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/* Largest write of a lane that is combined with those of other lanes.  */
+#ifndef NVPTX_WARP_WRITE_MAX
+#define NVPTX_WARP_WRITE_MAX 4096
+#endif
+
+/* Staging areas, each claimed by one group of lanes at a time, and their
+   size.  Groups whose writes don't fit, or whose warp finds its area
+   taken, stage on the heap instead.  */
+#ifndef NVPTX_WARP_WRITE_SLOTS
+#define NVPTX_WARP_WRITE_SLOTS 64
+#endif
+
+#ifndef NVPTX_WARP_WRITE_STAGING
+#define NVPTX_WARP_WRITE_STAGING 4096
+#endif
+
+/* Writes COUNT bytes of BUF for a whole group of lanes, setting
+   *NEW_COUNT_REF to the number written.  Returns 0 on success.  */
+typedef int __nvptx_warp_write_fn (void *ctx, const void *buf, size_t count,
+				   ssize_t *new_count_ref);
+
+extern int __nvptx_warp_write (int, const void *, size_t,
+			       __nvptx_warp_write_fn *, void *, ssize_t *);
+
+#endif /* _NVPTX_WARPWRITE_H_ */